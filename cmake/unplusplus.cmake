@@ -8,9 +8,9 @@ endif()
 function(add_unplusplus_clib name)
     # upp_clib_HEADER cxx_library
     cmake_parse_arguments(PARSE_ARGV 1 upp_clib
-        "NO_DEPRECATED"
-        "HEADER;LIBRARY;EXCLUDES_FILE"
-        "CXXFLAGS")
+        "NO_DEPRECATED;EXPORT_ALL;PCH;CLANG_MODULES;COMPACT_HEADER;QUARANTINE;BENCH;STABLE_NAMES"
+        "HEADER;LIBRARY;EXCLUDES_FILE;SPLIT_HEADERS;NAMES_FILE"
+        "CXXFLAGS;IMPORTS")
     cmake_path(ABSOLUTE_PATH upp_clib_HEADER NORMALIZE)
 
     if(NOT DEFINED upp_clib_HEADER)
@@ -29,25 +29,122 @@ function(add_unplusplus_clib name)
         list(APPEND upp_args "${upp_clib_EXCLUDES_FILE}")
     endif()
 
+    # The names are kept in the build directory, unless a file is given to keep with the sources
+    if(upp_clib_STABLE_NAMES AND NOT DEFINED upp_clib_NAMES_FILE)
+        set(upp_clib_NAMES_FILE "${CMAKE_CURRENT_BINARY_DIR}/${name}.names.json")
+    endif()
+    if(DEFINED upp_clib_NAMES_FILE)
+        cmake_path(ABSOLUTE_PATH upp_clib_NAMES_FILE NORMALIZE)
+        list(APPEND upp_args "--names-file")
+        list(APPEND upp_args "${upp_clib_NAMES_FILE}")
+    endif()
+
     if(upp_clib_NO_DEPRECATED)
         list(APPEND upp_args "--no-deprecated")
     endif()
 
+    if(DEFINED upp_clib_SPLIT_HEADERS)
+        list(APPEND upp_args "--split-headers=${upp_clib_SPLIT_HEADERS}")
+    endif()
+    if(upp_clib_COMPACT_HEADER)
+        list(APPEND upp_args "--compact-header")
+    endif()
+    if(upp_clib_QUARANTINE)
+        list(APPEND upp_args "--quarantine")
+    endif()
+    set(upp_bench_source)
+    if(upp_clib_BENCH)
+        list(APPEND upp_args "--bench")
+        set(upp_bench_source "${CMAKE_CURRENT_BINARY_DIR}/${name}_bench.cpp")
+    endif()
+
+    # Declarations that other clibs already wrap are used from them
+    set(upp_import_json)
+    foreach(import ${upp_clib_IMPORTS})
+        get_target_property(upp_json "${import}" UPP_JSON)
+        if(NOT upp_json)
+            message(FATAL_ERROR "${import} imported by ${name} is not a clib")
+        endif()
+        list(APPEND upp_args "--import")
+        list(APPEND upp_args "${upp_json}")
+        list(APPEND upp_import_json "${upp_json}")
+    endforeach()
+
     foreach(arg ${upp_clib_CXXFLAGS})
         list(APPEND upp_args "--extra-arg-before=${arg}")
     endforeach()
 
     add_custom_command(OUTPUT "${CMAKE_CURRENT_BINARY_DIR}/${name}.h"
         "${CMAKE_CURRENT_BINARY_DIR}/${name}.cpp"
+        "${CMAKE_CURRENT_BINARY_DIR}/${name}_inst.cpp"
         "${CMAKE_CURRENT_BINARY_DIR}/${name}.json"
+        "${CMAKE_CURRENT_BINARY_DIR}/${name}.map"
+        ${upp_bench_source}
         COMMAND "$<IF:$<TARGET_EXISTS:unplusplus>,$<TARGET_FILE:unplusplus>,${UNPLUSPLUS_EXECUTABLE}>"
         -o "${name}" "${upp_clib_HEADER}" ${upp_args}
         MAIN_DEPENDENCY "${upp_clib_HEADER}"
-        DEPENDS unplusplus "${upp_clib_EXCLUDES_FILE}")
-    add_library("${name}" "${CMAKE_CURRENT_BINARY_DIR}/${name}.cpp")
+        DEPFILE "${CMAKE_CURRENT_BINARY_DIR}/${name}.d"
+        DEPENDS unplusplus "${upp_clib_EXCLUDES_FILE}" ${upp_import_json})
+    add_library("${name}" "${CMAKE_CURRENT_BINARY_DIR}/${name}.cpp"
+        "${CMAKE_CURRENT_BINARY_DIR}/${name}_inst.cpp")
     target_include_directories("${name}" PUBLIC "${CMAKE_CURRENT_BINARY_DIR}")
     target_compile_options("${name}" PUBLIC "${upp_clib_CXXFLAGS}")
-    target_link_libraries("${name}" "${upp_clib_LIBRARY}")
+    target_link_libraries("${name}" "${upp_clib_LIBRARY}" ${upp_clib_IMPORTS})
+    set_target_properties("${name}" PROPERTIES UPP_JSON "${CMAKE_CURRENT_BINARY_DIR}/${name}.json")
+    # On Windows the users import the declarations from a DLL, but not from a static library
+    string(MAKE_C_IDENTIFIER "${name}" upp_macro)
+    target_compile_definitions("${name}" PUBLIC
+        "$<$<STREQUAL:$<TARGET_PROPERTY:${name},TYPE>,STATIC_LIBRARY>:${upp_macro}_CIFGEN_STATIC>")
+
+    # Only export the C API, so template instantiations from the C++ headers don't bloat the
+    # dynamic symbol table, and let the linker drop the code nothing uses.
+    if(NOT upp_clib_EXPORT_ALL)
+        set_target_properties("${name}" PROPERTIES
+            C_VISIBILITY_PRESET hidden
+            CXX_VISIBILITY_PRESET hidden
+            VISIBILITY_INLINES_HIDDEN ON)
+        if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+            target_compile_options("${name}" PRIVATE -ffunction-sections -fdata-sections)
+            set(upp_shared "$<STREQUAL:$<TARGET_PROPERTY:${name},TYPE>,SHARED_LIBRARY>")
+            if(APPLE)
+                target_link_options("${name}" PRIVATE "$<${upp_shared}:LINKER:-dead_strip>")
+            else()
+                set(upp_map "${CMAKE_CURRENT_BINARY_DIR}/${name}.map")
+                target_link_options("${name}" PRIVATE
+                    "$<${upp_shared}:LINKER:--gc-sections>"
+                    "$<${upp_shared}:LINKER:--version-script=${upp_map}>")
+                set_property(TARGET "${name}" APPEND PROPERTY LINK_DEPENDS "${upp_map}")
+            endif()
+        endif()
+    endif()
+
+    # Every stub source parses the wrapped header, so it can be parsed once into a precompiled
+    # header. It is force-included into sources that include it too, so it needs include guards.
+    if(upp_clib_PCH)
+        target_precompile_headers("${name}" PRIVATE
+            "$<$<COMPILE_LANGUAGE:CXX>:${upp_clib_HEADER}>")
+    endif()
+
+    # A module map lets clang reuse the generated header between the users' sources. The library's
+    # own sources include it textually, since an import wouldn't see ${name}_CIFGEN_BUILD.
+    if(upp_clib_CLANG_MODULES AND CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        set(upp_modulemap "${CMAKE_CURRENT_BINARY_DIR}/${name}.modulemap")
+        string(MAKE_C_IDENTIFIER "${name}" upp_module)
+        file(WRITE "${upp_modulemap}"
+            "module ${upp_module} {\n  header \"${name}.h\"\n  export *\n}\n")
+        target_compile_options("${name}" INTERFACE
+            "$<$<COMPILE_LANG_AND_ID:C,Clang,AppleClang>:-fmodules>"
+            "$<$<COMPILE_LANG_AND_ID:CXX,Clang,AppleClang>:-fmodules>"
+            "$<$<COMPILE_LANG_AND_ID:C,Clang,AppleClang>:-fmodule-map-file=${upp_modulemap}>"
+            "$<$<COMPILE_LANG_AND_ID:CXX,Clang,AppleClang>:-fmodule-map-file=${upp_modulemap}>")
+    endif()
+
+    # The benchmark times the stubs against the C++ functions, and writes ${name}_bench.csv
+    if(upp_clib_BENCH)
+        add_executable("${name}_bench" "${upp_bench_source}")
+        target_link_libraries("${name}_bench" "${name}" "${upp_clib_LIBRARY}")
+        target_compile_features("${name}_bench" PRIVATE cxx_std_17)
+    endif()
 
     set(${name}_HEADERS "${CMAKE_CURRENT_BINARY_DIR}" PARENT_SCOPE)
     set(${name}_JSON "${CMAKE_CURRENT_BINARY_DIR}/${name}.json" PARENT_SCOPE)
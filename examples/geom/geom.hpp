@@ -32,6 +32,7 @@ class Point2D : Point<T, 2> {
 };
 
 typedef Point2D<int> Point2Di;
+extern template class Point2D<int>;
 typedef Point2D<double> Point2Dd;
 int dot(Point2Di a, Point2Di b);
 float dot(Point2D<float> &a, Point2D<float> &b);
@@ -10,30 +10,27 @@ int main(int argc, char *argv[]) {
   upp_geom_Point2D_int *a = upp_new_geom_Point2D_int(2, 3);
   struct upp_geom_Point2D_int_s_ b = {{5, 6}};
 
-  printf("Dot: %d\n", upp_geom_dot(a, &b));
+  // Point2D<int> is trivially copyable, so it is passed by value
+  printf("Dot: %d\n", upp_geom_dot(*a, b));
 
   upp_del_geom_Point2D_int(a);
 
   upp_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3 *v =
       upp_new_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3();
-  upp_geom_Point_double_3 *pt = NULL;
-  pt = upp_new_geom_Point_double_3();
-  upp_geom_Point_double_3_set_axes(pt, 0, 1);
-  upp_geom_Point_double_3_set_axes(pt, 1, 2);
-  upp_geom_Point_double_3_set_axes(pt, 2, 3);
-  upp_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3_push_back(v, pt);
-  pt = upp_new_geom_Point_double_3();
-  upp_geom_Point_double_3_set_axes(pt, 0, 4);
-  upp_geom_Point_double_3_set_axes(pt, 1, 5);
-  upp_geom_Point_double_3_set_axes(pt, 2, 6);
-  upp_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3_push_back(v, pt);
-  pt = upp_new_geom_Point_double_3();
-  upp_geom_centroid_double_3(pt, v);
+  // Trivially copyable elements are copied into the vector in bulk
+  struct upp_geom_Point_double_3_s_ pts[2] = {{{1, 2, 3}}, {{4, 5, 6}}};
+  upp_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3_assign_from(v, pts, 2);
+  size_t length = 0;
+  upp_geom_Point_double_3 *data =
+      upp_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3_span(v, &length);
+  upp_geom_Point_double_3_set_axes(&data[length - 1], 2, 7);
+  // The centroid is small and trivially copyable, so it's returned by value
+  struct upp_geom_Point_double_3_s_ c;
+  c = upp_geom_centroid_double_3(v);
   printf("Centroid: %f, %f, %f\n",
-         upp_geom_Point_double_3_get_axis(pt, 0),
-         upp_geom_Point_double_3_get_axis(pt, 1),
-         upp_geom_Point_double_3_get_axis(pt, 2));
-  upp_del_geom_Point_double_3(pt);
+         upp_geom_Point_double_3_get_axis(&c, 0),
+         upp_geom_Point_double_3_get_axis(&c, 1),
+         upp_geom_Point_double_3_get_axis(&c, 2));
   upp_del_std_vector_geom_Point_double_3_std_allocator_geom_Point_double_3(v);
   return 0;
 }
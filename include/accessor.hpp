@@ -0,0 +1,49 @@
+/*
+ * unplusplus
+ * Copyright 2021 Eric Eaton
+ */
+
+#pragma once
+
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Expr.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "identifier.hpp"
+
+namespace unplusplus {
+// The designators of the fields of a class in its mirror struct
+typedef std::unordered_map<const clang::FieldDecl *, std::string> FieldNames;
+
+/*
+ * Translates the body of a trivial method into C that works directly on the mirror struct. Only
+ * loads and stores of fields, parameters, literals and builtin arithmetic are accepted.
+ */
+class AccessorTranslator {
+  const clang::CXXMethodDecl *_d;
+  const IdentifierConfig &_cfg;
+  const std::vector<std::string> &_params;
+  const FieldNames *_fields;
+
+  bool stmt(const clang::Stmt *S, std::ostream &os);
+  bool expr(const clang::Expr *E, std::ostream &os);
+  bool field(const clang::MemberExpr *ME, std::ostream &os);
+
+ public:
+  /**
+   * @param[in] MD The method, which must have a body
+   * @param[in] cfg The naming configuration
+   * @param[in] params The C names of the parameters
+   * @param[in] fields The fields of the mirror struct, or null to only check the body's structure
+   */
+  AccessorTranslator(const clang::CXXMethodDecl *MD, const IdentifierConfig &cfg,
+                     const std::vector<std::string> &params, const FieldNames *fields)
+      : _d(MD), _cfg(cfg), _params(params), _fields(fields) {}
+
+  // Get the lines of the C function body, or an empty string if it can't be translated.
+  std::string translate();
+};
+}  // namespace unplusplus
@@ -8,6 +8,7 @@
 #include <clang/AST/CXXInheritance.h>
 #include <clang/AST/DeclCXX.h>
 
+#include "accessor.hpp"
 #include "jobs.hpp"
 
 namespace unplusplus {
@@ -85,14 +86,36 @@ class ClassDefineJob : public Job<clang::CXXRecordDecl> {
   };
   bool _no_ctor = false;
   FieldInfo _fields;
+  // The element type, if this is a container with contiguous storage that can be copied in bulk
+  clang::QualType _contiguous;
+  // The element type, if this is a container that can be iterated with a callback
+  clang::QualType _iterable;
+  // The byte offset of each mirrored field, by its designator in the C struct
+  std::vector<std::pair<std::string, int64_t>> _offsets;
+  // The explicitly aligned classes whose first field was already given their alignment
+  std::unordered_set<const clang::CXXRecordDecl *> _aligned;
 
   std::string nameField(const std::string &original);
   void findFields();
   void addFields(const clang::CXXRecordDecl *d, ClassList parents, FieldInfo &list);
   void writeFields(FieldInfo &list, Json::Value &j, std::string indent = "  ",
-                   std::unordered_set<std::string> *names = nullptr);
+                   std::unordered_set<std::string> *names = nullptr, int64_t base = -1,
+                   const std::string &prefix = "");
+  // Get the offset in bits of the base class at the end of the inheritance path
+  uint64_t baseOffset(ClassList &path);
+  // Get the alignment in bits the field needs in the mirror struct, or 0 if its type's is right
+  uint64_t fieldAlign(const FieldInfo &f, uint64_t offset);
+  void findContiguous();
+  void writeContiguous(const Identifier &i, Json::Value &j);
+  void findIterable();
+  void writeIterable(const Identifier &i, Json::Value &j);
 
  public:
+  // The designators of the fields in the mirror struct of each class, once it's written
+  static std::unordered_map<const clang::CXXRecordDecl *, FieldNames> fieldNames;
+  // The specializations whose members were instantiated here, rather than by the library
+  static std::unordered_set<const clang::ClassTemplateSpecializationDecl *> instantiated;
+
   static bool accept(type *D, const IdentifierConfig &cfg, clang::Sema &S);
   ClassDefineJob(type *D, clang::Sema &S, JobManager &manager);
   void impl() override;
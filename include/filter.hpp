@@ -56,7 +56,10 @@ class DeclFilter {
   clang::PrintingPolicy _pp;
   std::unordered_map<const clang::Decl *, bool> _cheaderd;
   std::unordered_map<std::string, bool> _cheader;
+  std::unordered_map<std::string, bool> _wrapped;
   std::vector<std::string> _headerPatterns;
+  // The declarations that were excluded because they failed, with the reason
+  std::vector<std::pair<std::string, std::string>> _quarantined;
   bool predicate(const clang::Decl *D);
 
  public:
@@ -66,11 +69,20 @@ class DeclFilter {
   // another name by a typedef or similar construct.
   bool filterOut(const clang::Decl *D);
 
+  // Exclude the declaration from now on, because it can't be used
+  void quarantine(const clang::Decl *D, const std::string &reason);
+  const std::vector<std::pair<std::string, std::string>> &quarantined() { return _quarantined; }
+
   // Scrub any filtered-out decls from the type, but leave the size of the resulting type the same
   void sanitizeType(clang::QualType &QT, const clang::ASTContext &AC);
 
   bool matchHeader(std::string &S);
   bool isCHeader(const clang::Decl *D);
+  // Whether the location is in a header that is known to be C
+  bool isCHeader(clang::SourceLocation L, const clang::SourceManager &SM);
+  // Whether the location is in the wrapped header, or a header next to it or below it that isn't
+  // a system header
+  bool isWrappedHeader(clang::SourceLocation L, const clang::SourceManager &SM);
 
   const clang::PrintingPolicy &PP() { return _pp; }
 };
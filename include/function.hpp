@@ -13,9 +13,50 @@ class FunctionJob : public Job<clang::FunctionDecl> {
   clang::QualType _returnType;
   clang::QualType _returnParamType;
   bool _returnParam;
+  // The record returned by value is constructed in the storage supplied by the caller
+  bool _returnConstruct;
   std::vector<bool> _paramDeref;
+  // The string, view or span type to construct from a pointer and length, for each parameter
+  std::vector<clang::QualType> _paramSpan;
+  // The pointer to the characters or elements of a returned string, view or span
+  clang::QualType _returnSpan;
+  // The returned string is copied into a buffer supplied by the caller
+  bool _returnBuffer = false;
+  bool _nothrow = false;
+  // Exceptions are caught and stored in the thread-local error instead of escaping the stub
+  bool _translate = false;
+  // Also emit a variant that loops over arrays of arguments
+  bool _batch = false;
+  // Also emit a static inline C version of a trivial accessor
+  bool _inline = false;
+  std::vector<std::string> _paramNames;
+
+  // Whether the record can be passed or returned by value as its mirror struct
+  bool byValue(clang::QualType QT);
+  // Get the element pointed to by a std string, string view or span, if the type is one.
+  static clang::QualType bridgedElement(clang::QualType QT, bool &owned);
+  bool wantsBatch();
+  // Write the lines of the stub body, wrapped to translate exceptions if needed
+  void writeBody(const std::string &block, bool value);
+  void writeBatch(const Identifier &i, const std::string &fname);
+  // Get the statement of the stub body that calls the function through callee
+  std::string statement(const std::string &callee, const std::string &call);
+  // Write a function that returns the final overrider of a virtual method as a C function pointer
+  void writeResolve(const Identifier &i, Json::Value &j);
+  // Whether the method is a trivial accessor that can be translated to C
+  bool wantsInline(clang::CXXMethodDecl *M);
+  void writeInline(const Identifier &i, const std::string &params, Json::Value &j);
+  // Get a key that is the same for stubs that compile to the same code, or empty if unknown
+  std::string aliasKey();
+  // Get the declaration to explicitly instantiate the method, or empty if it can't be
+  std::string instantiation(const std::string &fname);
+  // Time the stub in the benchmark, if it can be called with zero arguments
+  void addBenchmark(const Identifier &i, const std::string &fname);
 
  public:
+  // The first stub emitted for each alias key
+  static std::unordered_map<std::string, std::string> stubs;
+
   static bool accept(const type *D);
   FunctionJob(type *D, clang::Sema &S, JobManager &manager);
   void impl() override;
@@ -9,6 +9,7 @@
 #include <clang/AST/Decl.h>
 #include <clang/AST/PrettyPrinter.h>
 
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -31,6 +32,32 @@ struct IdentifierConfig {
   std::string _enum = "_e_";
   std::string _dtor = "del_";
   std::string _ctor = "new_";
+  std::string _destroy = "destroy_";
+  std::string _noexcept = "UPP_NOEXCEPT";
+  std::string _alignas = "UPP_ALIGNAS";
+  std::string _packed = "UPP_PACKED";
+  std::string _batch = "batch";
+  std::string _count = "_upp_count";
+  std::string _index = "_upp_i";
+  std::string _length = "_len";
+  std::string _direct = "direct";
+  std::string _resolve = "resolve_";
+  std::string _result = "_upp_result";
+  std::string _api = "api";
+  std::string _inline = "inline";
+  // leave out template arguments that are the same as the default
+  bool _elideDefaultArgs = false;
+  // template arguments with longer names are replaced with a hash, or 0 for no limit
+  size_t _maxTemplateLength = 0;
+  // the names of the template arguments that were replaced with a hash, and the hashes
+  mutable std::map<std::string, std::string> _shortNames;
+  // keep the C names of declarations the same between runs, by the USRs of the declarations
+  bool _stableNames = false;
+  // the C name given to each USR, in this run or an earlier one, and all of those names
+  mutable std::map<std::string, std::string> _pinned;
+  mutable std::unordered_set<std::string> _reserved;
+  // the C names of the declarations wrapped by imported libraries, by USR
+  std::map<std::string, std::string> _imported;
   // this is needed for clang to print things correctly, like bool
   clang::PrintingPolicy PP;
   DeclFilter &_df;
@@ -46,6 +73,9 @@ struct IdentifierConfig {
   // Get the decl name, with qualifier and template arguments
   std::string getCXXQualifiedName(const clang::Decl *D) const;
 
+  // Get the USR of the declaration, which is the same in every translation unit, or empty
+  std::string getUSR(const clang::Decl *D) const;
+
   // Get an informative name, functions will have return & arguments
   std::string getDebugName(const clang::Decl *d) const;
   std::string getDebugName(const clang::QualType &d) const;
@@ -53,6 +83,9 @@ struct IdentifierConfig {
   // Prints an alternate mangling for template arguments
   void printCTemplateArgs(std::ostream &os,
                           const llvm::ArrayRef<clang::TemplateArgument> &Args) const;
+  // Prints the template arguments of a specialization of the template, shortened as configured
+  void printCTemplateArgs(std::ostream &os, const clang::TemplateDecl *TD,
+                          const llvm::ArrayRef<clang::TemplateArgument> &Args) const;
   // Prints an alternate mangling for type as a template argument
   void printCTemplateArg(std::ostream &os, clang::QualType QT) const;
   // Prints an alternate mangling for the template argument
@@ -97,4 +130,7 @@ std::string getCXXQualifiedName(const clang::PrintingPolicy &PP, const clang::De
 // If the NamedDecl is an anonymous struct or enum, get the typedef that is giving it a name.
 const clang::TypedefDecl *getAnonTypedef(const clang::NamedDecl *d);
 
+// A hash of the string that is the same across runs and platforms (64-bit FNV-1a)
+uint64_t stableHash(const std::string &s);
+
 }  // namespace unplusplus
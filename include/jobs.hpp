@@ -35,14 +35,26 @@ class JobBase {
   std::list<JobBase *> _depends;    // Dependencies of this job (minus those that are done)
   std::list<JobBase *> _dependent;  // Jobs that depend on this job
   bool _done = false;
+  bool _failed = false;
+
+  // Give up on the job and the jobs that depend on it, and exclude their declarations
+  void fail(const std::string &reason);
 
  protected:
   Outputs &_out;
   std::string _name;
   clang::Sema &_s;
+  // The part of a split header that the job writes to, or empty for the shared header
+  std::string _partition;
   // This function should be overidden as the *only* code that writes to the output(s), and it
   // should *not* set any dependencies.
   virtual void impl() = 0;
+  // Declare a function of the C API in the header, so that it's exported from the library.
+  void exportFunction(const std::string &name, const std::string &signature);
+  // Get the part of a split header where the declaration belongs
+  std::string partitionOf(const clang::Decl *D);
+  // Write the location and name of the declaration, unless the header is compact
+  void writeComment(const std::string &location);
 
  public:
   JobBase(JobManager &manager, clang::Sema &S);
@@ -52,6 +64,9 @@ class JobBase {
   clang::ASTNameGenerator &nameGen();
   JobManager &manager() { return _manager; }
   bool isDone() const { return _done; }
+  bool isFailed() const { return _failed; }
+  // The declaration that the job processes, if any
+  virtual clang::Decl *decl() const { return nullptr; }
   const std::string &name() const { return _name; }
   const std::list<JobBase *> &dependencies() { return _depends; }
 
@@ -81,6 +96,7 @@ class Job : public JobBase {
         _location(_d->getLocation().printToString(_d->getASTContext().getSourceManager())) {
     _name = cfg().getDebugName(D);
   }
+  clang::Decl *decl() const override { return _d; }
 };
 
 extern template class Job<clang::TypedefDecl>;
@@ -101,6 +117,9 @@ class TypedefJob : public Job<clang::TypedefDecl> {
 
 class VarJob : public Job<clang::VarDecl> {
   clang::QualType _ptr;
+  // The C expression of the value of a constant, or empty if it's accessed through a pointer
+  std::string _value;
+  void evaluate();
 
  public:
   VarJob(type *D, clang::Sema &S, JobManager &jm);
@@ -121,14 +140,25 @@ class JobManager {
   std::queue<clang::TemplateDecl *> _templates;
   std::queue<JobBase *> _ready;
   std::queue<clang::Decl *> _lazy;
+  // The USRs of the declarations that imported libraries define, not just forward declare
+  std::unordered_set<std::string> _importedDefinitions;
+  // The functions of the C API in the order they were emitted, and their function pointer members
+  std::vector<std::pair<std::string, std::string>> _api;
+
+  // Emit the thread-local error state used by stubs that translate exceptions
+  void writeErrorRuntime();
+  // Emit a table of pointers to all the functions, so they can be loaded with a single symbol
+  void writeApi();
+  // Read and write the C names of declarations, so they stay the same between runs
+  void readNames();
+  void writeNames();
+  // Read the declarations wrapped by a library generated earlier, and include its header
+  void readImport(const std::string &path);
+  // Record the C names of the declarations, for libraries that import this one
+  void writeDeclarations();
 
  public:
-  JobManager(Outputs &out, clang::ASTContext &ASTC, DeclFilterConfig &FC)
-      : _out(out),
-        _filter(ASTC.getLangOpts(), FC),
-        _cfg(ASTC.getLangOpts(), _filter),
-        _jcfg(_cfg, ASTC, out),
-        _ng(ASTC) {}
+  JobManager(Outputs &out, clang::ASTContext &ASTC, DeclFilterConfig &FC);
   ~JobManager();
 
   Outputs &out() { return _out; }
@@ -137,6 +167,9 @@ class JobManager {
   JsonConfig &jcfg() { return _jcfg; }
   clang::ASTNameGenerator &nameGen() { return _ng; }
   void flush(clang::Sema &S);
+  // Get the part of a split header for what is declared at the location, in the context
+  std::string partitionOf(clang::SourceLocation Loc, const clang::SourceManager &SM,
+                          const clang::DeclContext *DC = nullptr);
 
   // Apply the operator to the declarations nested in the type
   void traverse(clang::QualType QT, std::function<void(clang::Decl *)> OP);
@@ -158,6 +191,8 @@ class JobManager {
   void declare(clang::Decl *D, JobBase *J) { _declarations[D] = J; }
   void define(clang::Decl *D, JobBase *J) { _definitions[D] = J; }
   bool isDefined(clang::Decl *D);
+  // Let jobs depend on the declaration if an imported library wraps it, and tell if it does
+  bool importDecl(clang::Decl *D);
   bool prevDeclared(clang::Decl *D);
 
   // Rename the filtered-out declaration using the new declaration that isn't filtered out.
@@ -171,6 +206,11 @@ class JobManager {
   // discovered while emitting the known ones.
   void finishTemplates(clang::Sema &S);
 
+  // Add a function to the API table, given the name and the signature it was declared with.
+  void addApi(const std::string &name, const std::string &signature);
+  // Emit what is left once all the declarations are done.
+  void finish();
+
   friend class JobBase;
 };
 }  // namespace unplusplus
@@ -39,6 +39,34 @@ struct JsonConfig {
   const std::string _fieldBits = "bits";
   const std::string _fieldType = "type";
   const std::string _variadic = "variadic";
+  const std::string _uninitialized = "uninitialized";
+  const std::string _noexcept = "noexcept";
+  const std::string _translated = "translate_exceptions";
+  const std::string _batch = "batch";
+  const std::string _contiguous = "contiguous";
+  const std::string _iterable = "iterable";
+  const std::string _virtual = "virtual";
+  const std::string _final = "final";
+  const std::string _direct = "direct";
+  const std::string _resolve = "resolve";
+  const std::string _inline = "inline";
+  const std::string _macro = "macro";
+  const std::string _aliasOf = "alias_of";
+  const std::string _quarantine = "quarantine";
+  const std::string _reason = "reason";
+  const std::string _shortNames = "short_names";
+  const std::string _value = "value";
+  const std::string _api = "api";
+  const std::string _apiVersion = "api_version";
+  const std::string _size = "size";
+  const std::string _align = "align";
+  const std::string _packed = "packed";
+  const std::string _maxFieldAlign = "max_field_align";
+  const std::string _offset = "offset";
+  const std::string _bitOffset = "bit_offset";
+  const std::string _header = "header";
+  const std::string _declarations = "declarations";
+  const std::string _defined = "defined";
 
   JsonConfig(const IdentifierConfig &IC, const clang::ASTContext &AC, Outputs &Out);
   Json::Value jsonType(const clang::QualType &QT);
@@ -9,9 +9,24 @@
 
 extern llvm::cl::OptionCategory UppCategory;
 
+// How the generated header is split into smaller headers
+enum SplitMode { SplitNone, SplitNamespace, SplitSource };
+
 extern llvm::cl::opt<std::string> OutStem;
 extern llvm::cl::opt<std::string> ExcludesFile;
 extern llvm::cl::list<std::string> ExcludeDecl;
 extern llvm::cl::list<std::string> CHeadersFiles;
 extern llvm::cl::opt<bool> NoDeprecated;
 extern llvm::cl::opt<bool> Verbose;
+extern llvm::cl::opt<bool> TranslateExceptions;
+extern llvm::cl::list<std::string> BatchPatterns;
+extern llvm::cl::opt<bool> InlineAccessors;
+extern llvm::cl::opt<bool> ElideDefaultTemplateArgs;
+extern llvm::cl::opt<unsigned> MaxTemplateNameLength;
+extern llvm::cl::opt<bool> AliasStubs;
+extern llvm::cl::opt<SplitMode> SplitHeaders;
+extern llvm::cl::opt<bool> CompactHeader;
+extern llvm::cl::opt<bool> Quarantine;
+extern llvm::cl::opt<bool> Bench;
+extern llvm::cl::opt<std::string> NamesFile;
+extern llvm::cl::list<std::string> Imports;
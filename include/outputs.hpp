@@ -10,39 +10,134 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <sstream>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 
 #include "identifier.hpp"
 
 namespace unplusplus {
+struct OutputConfig {
+  // Whether the header is split into partitions, with an umbrella header
+  bool split = false;
+  // Whether to generate a program to benchmark the stubs
+  bool bench = false;
+};
+
+// A stub to time against a direct call, given the statement declaring the object it needs, if any
+struct Benchmark {
+  std::string name;
+  std::string setup;
+  std::string cpp;
+  std::string c;
+};
+
 class Outputs {
  public:
   virtual std::ostream &hf() = 0;
   virtual std::ostream &sf() = 0;
   virtual Json::Value &json() = 0;
+  // An entry of a JSON section, which is restored by rollback() if it is changed after mark()
+  virtual Json::Value &jsonEntry(const std::string &section, const std::string &name) = 0;
   virtual void addCHeader(const std::string &path) = 0;
+  // Include the generated header of an imported library, outside the C linkage block
+  virtual void addImport(const std::string &path) = 0;
+  // The file name of the generated header, for libraries that import this one to include
+  virtual std::string headerName() = 0;
+  // A name for the library that is usable in C identifiers
+  virtual const std::string &libName() = 0;
+  // The macro that exports a declaration from the library
+  virtual const std::string &exportMacro() = 0;
+  // Add a symbol to the list of symbols exported from the library
+  virtual void addExport(const std::string &name) = 0;
+  // Add a template member that the library explicitly instantiates once for all stubs
+  virtual void addInstantiation(const std::string &decl) = 0;
+  // Add a file that the outputs depend on
+  virtual void addDependency(const std::string &path) = 0;
+  // Direct the header output to the named part of a split header, or the shared one if empty
+  virtual void setPartition(const std::string &name) = 0;
+  // Add a declaration to the generated excludes file
+  virtual void addExclusion(const std::string &name) = 0;
+  virtual void addBenchmark(const Benchmark &bench) = 0;
+  // Remember the state of the outputs, and later discard everything written after it
+  virtual void mark() = 0;
+  virtual void rollback() = 0;
 };
 
 class FileOutputs : public Outputs {
   std::filesystem::path _outheader;
   std::filesystem::path _outsource;
   std::filesystem::path _outjson;
+  std::filesystem::path _outmap;
+  std::filesystem::path _outinst;
+  std::filesystem::path _outdep;
+  std::filesystem::path _outexcludes;
+  std::filesystem::path _outtypes;
+  std::filesystem::path _outbench;
   std::ofstream _hf;
   std::ofstream _sf;
   Json::Value _json;
+  OutputConfig _cfg;
+  // The headers split from the shared one, with the partition being written to
+  std::map<std::string, std::ostringstream> _parts;
+  std::ostringstream *_part = nullptr;
   std::string _macroname;
+  std::string _exportmacro;
+  std::vector<std::string> _exports;
+  std::vector<std::string> _instantiations;
+  std::set<std::string> _dependencies;
+  std::vector<std::string> _exclusions;
+  std::vector<Benchmark> _benchmarks;
+  std::vector<std::string> _cheaderOrder;
+  std::vector<std::string> _importOrder;
+  struct {
+    // The length of each part that was written to since the mark
+    std::map<std::ostringstream *, std::streampos> parts;
+    std::streampos hf, sf;
+    size_t exports, instantiations, cheaders, imports, benchmarks;
+    // The previous values of the JSON entries changed since the mark, null if there was none
+    std::vector<std::tuple<std::string, std::string, Json::Value>> json;
+  } _mark;
   std::unordered_set<std::string> _cheaders;
+  std::unordered_set<std::string> _imports;
   std::unordered_set<std::string> _exclude_headers;
 
+  // Write the parts of a split header, and the umbrella header that includes them all
+  void writeParts();
+  void writeBench();
+
  public:
-  FileOutputs(const std::filesystem::path &stem, const std::vector<std::string> &sources);
+  /**
+   * @param[in] stem The path of the outputs, without extension
+   * @param[in] sources The C++ headers that are wrapped
+   * @param[in] cfg Which optional outputs to generate
+   */
+  FileOutputs(const std::filesystem::path &stem, const std::vector<std::string> &sources,
+              const OutputConfig &cfg = OutputConfig());
   ~FileOutputs();
-  std::ostream &hf() override { return _hf; }
+  std::ostream &hf() override {
+    if (_part) return *_part;
+    return _hf;
+  }
   std::ostream &sf() override { return _sf; }
   Json::Value &json() override { return _json; }
+  Json::Value &jsonEntry(const std::string &section, const std::string &name) override;
   void addCHeader(const std::string &path) override;
+  void addImport(const std::string &path) override;
+  std::string headerName() override { return _outheader.filename().string(); }
+  const std::string &libName() override { return _macroname; }
+  const std::string &exportMacro() override { return _exportmacro; }
+  void addExport(const std::string &name) override { _exports.push_back(name); }
+  void addInstantiation(const std::string &decl) override { _instantiations.push_back(decl); }
+  void addDependency(const std::string &path) override { _dependencies.emplace(path); }
+  void setPartition(const std::string &name) override;
+  void addExclusion(const std::string &name) override { _exclusions.push_back(name); }
+  void addBenchmark(const Benchmark &bench) override { _benchmarks.push_back(bench); }
+  void mark() override;
+  void rollback() override;
 };
 
 class SubOutputs : public Outputs {
@@ -56,7 +151,22 @@ class SubOutputs : public Outputs {
   std::ostream &hf() override { return _hf; }
   std::ostream &sf() override { return _sf; }
   Json::Value &json() override { return _parent.json(); }
+  Json::Value &jsonEntry(const std::string &section, const std::string &name) override {
+    return _parent.jsonEntry(section, name);
+  }
   void addCHeader(const std::string &path) override { _parent.addCHeader(path); }
+  void addImport(const std::string &path) override { _parent.addImport(path); }
+  std::string headerName() override { return _parent.headerName(); }
+  const std::string &libName() override { return _parent.libName(); }
+  const std::string &exportMacro() override { return _parent.exportMacro(); }
+  void addExport(const std::string &name) override { _parent.addExport(name); }
+  void addInstantiation(const std::string &decl) override { _parent.addInstantiation(decl); }
+  void addDependency(const std::string &path) override { _parent.addDependency(path); }
+  void setPartition(const std::string &name) override { _parent.setPartition(name); }
+  void addExclusion(const std::string &name) override { _parent.addExclusion(name); }
+  void addBenchmark(const Benchmark &bench) override { _parent.addBenchmark(bench); }
+  void mark() override { _parent.mark(); }
+  void rollback() override { _parent.rollback(); }
   void erase() {
     _hf.str("");
     _sf.str("");
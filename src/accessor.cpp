@@ -0,0 +1,180 @@
+/*
+ * unplusplus
+ * Copyright 2021 Eric Eaton
+ */
+
+#include "accessor.hpp"
+
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/StmtCXX.h>
+
+#include <sstream>
+
+using namespace unplusplus;
+using namespace clang;
+
+// Only types that are spelled and behave the same in C and C++ are accepted.
+static bool isPlain(QualType QT) {
+  QT = QT.getCanonicalType();
+  return !QT->isEnumeralType() && (QT->isIntegerType() || QT->isRealFloatingType());
+}
+
+// Conversions between plain types are made explicit, so C converts the same way.
+static bool isArithmeticCast(CastKind K) {
+  switch (K) {
+    case CK_IntegralCast:
+    case CK_FloatingCast:
+    case CK_IntegralToFloating:
+    case CK_FloatingToIntegral:
+    case CK_IntegralToBoolean:
+    case CK_FloatingToBoolean:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::string AccessorTranslator::translate() {
+  if (!isPlain(_d->getReturnType()) && !_d->getReturnType()->isVoidType()) return "";
+  for (const auto *P : _d->parameters()) {
+    if (!isPlain(P->getType())) return "";
+  }
+  const auto *CS = dyn_cast_or_null<CompoundStmt>(_d->getBody());
+  if (!CS || CS->body_empty()) return "";
+
+  std::stringstream os;
+  for (const auto *S : CS->body()) {
+    // nothing can follow a return
+    if (isa<ReturnStmt>(S) && S != CS->body_back()) return "";
+    if (!stmt(S, os)) return "";
+  }
+  return os.str();
+}
+
+bool AccessorTranslator::stmt(const Stmt *S, std::ostream &os) {
+  if (const auto *RS = dyn_cast<ReturnStmt>(S)) {
+    os << "  return";
+    if (const Expr *E = RS->getRetValue()) {
+      os << " ";
+      if (!expr(E, os)) return false;
+    }
+    os << ";\n";
+    return true;
+  }
+  const auto *BO = dyn_cast<BinaryOperator>(S);
+  if (!BO || !BO->isAssignmentOp()) return false;
+  os << "  ";
+  if (!expr(BO, os)) return false;
+  os << ";\n";
+  return true;
+}
+
+bool AccessorTranslator::expr(const Expr *E, std::ostream &os) {
+  if (const auto *PE = dyn_cast<ParenExpr>(E)) {
+    os << "(";
+    if (!expr(PE->getSubExpr(), os)) return false;
+    os << ")";
+    return true;
+  }
+  if (const auto *IL = dyn_cast<IntegerLiteral>(E)) {
+    SmallString<16> s;
+    IL->getValue().toString(s, 10, IL->getType()->isSignedIntegerType());
+    if (IL->getType()->isSpecificBuiltinType(BuiltinType::Int))
+      os << s.c_str();
+    else
+      os << "((" << Identifier(IL->getType(), Identifier(), _cfg).c << ")" << s.c_str() << ")";
+    return true;
+  }
+  if (const auto *FL = dyn_cast<FloatingLiteral>(E)) {
+    SmallString<32> s;
+    FL->getValue().toString(s, 0, 0);
+    os << "((" << Identifier(FL->getType(), Identifier(), _cfg).c << ")" << s.c_str() << ")";
+    return true;
+  }
+  if (const auto *BL = dyn_cast<CXXBoolLiteralExpr>(E)) {
+    os << (BL->getValue() ? "1" : "0");
+    return true;
+  }
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const auto *PVD = dyn_cast<ParmVarDecl>(DRE->getDecl());
+    if (!PVD) return false;
+    unsigned i = PVD->getFunctionScopeIndex();
+    os << (i < _params.size() ? _params[i] : getName(PVD));
+    return true;
+  }
+  if (const auto *ME = dyn_cast<MemberExpr>(E)) {
+    return field(ME, os);
+  }
+  if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+    if (!isPlain(ASE->getType())) return false;
+    if (!expr(ASE->getBase(), os)) return false;
+    os << "[";
+    if (!expr(ASE->getIdx(), os)) return false;
+    os << "]";
+    return true;
+  }
+  if (const auto *CE = dyn_cast<CastExpr>(E)) {
+    CastKind K = CE->getCastKind();
+    if (isArithmeticCast(K) && isPlain(CE->getType())) {
+      os << "((" << Identifier(CE->getType(), Identifier(), _cfg).c << ")";
+      if (!expr(CE->getSubExpr(), os)) return false;
+      os << ")";
+      return true;
+    }
+    if (K == CK_LValueToRValue || K == CK_NoOp || K == CK_ArrayToPointerDecay) {
+      return expr(CE->getSubExpr(), os);
+    }
+    return false;
+  }
+  if (const auto *BO = dyn_cast<BinaryOperator>(E)) {
+    if (BO->isCommaOp() || BO->isPtrMemOp() || BO->getOpcode() == BO_Cmp) return false;
+    if (!isPlain(BO->getType())) return false;
+    if (!expr(BO->getLHS(), os)) return false;
+    os << " " << BO->getOpcodeStr().str() << " ";
+    return expr(BO->getRHS(), os);
+  }
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    UnaryOperatorKind K = UO->getOpcode();
+    if (K != UO_Minus && K != UO_Plus && K != UO_Not && K != UO_LNot) return false;
+    if (!isPlain(UO->getType())) return false;
+    os << UnaryOperator::getOpcodeStr(K).str();
+    return expr(UO->getSubExpr(), os);
+  }
+  if (const auto *CO = dyn_cast<ConditionalOperator>(E)) {
+    if (!isPlain(CO->getType())) return false;
+    if (!expr(CO->getCond(), os)) return false;
+    os << " ? ";
+    if (!expr(CO->getTrueExpr(), os)) return false;
+    os << " : ";
+    return expr(CO->getFalseExpr(), os);
+  }
+  return false;
+}
+
+bool AccessorTranslator::field(const MemberExpr *ME, std::ostream &os) {
+  const auto *FD = dyn_cast<FieldDecl>(ME->getMemberDecl());
+  if (!FD) return false;
+  QualType QT = FD->getType().getCanonicalType();
+  if (const auto *AT = dyn_cast<ConstantArrayType>(QT)) QT = AT->getElementType();
+  if (!isPlain(QT)) return false;
+
+  // Fields of anonymous structs and unions are reached through the implicit field holding them.
+  // Casts to the base classes are dropped, since their fields are also in the mirror struct.
+  const Expr *base = ME->getBase()->IgnoreParenImpCasts();
+  while (const auto *inner = dyn_cast<MemberExpr>(base)) {
+    const auto *anon = dyn_cast<FieldDecl>(inner->getMemberDecl());
+    if (!anon || !anon->isAnonymousStructOrUnion()) return false;
+    base = inner->getBase()->IgnoreParenImpCasts();
+  }
+  if (!isa<CXXThisExpr>(base)) return false;
+
+  if (!_fields) {
+    os << _cfg._this << "->" << getName(FD);
+    return true;
+  }
+  auto it = _fields->find(FD);
+  // the field may be missing, or there could be more than one copy of it in the mirror struct
+  if (it == _fields->end() || it->second.empty()) return false;
+  os << _cfg._this << "->" << it->second;
+  return true;
+}
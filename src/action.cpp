@@ -10,6 +10,7 @@
 #include <clang/Index/IndexingOptions.h>
 
 #include "jobs.hpp"
+#include "options.hpp"
 
 using namespace unplusplus;
 using namespace clang;
@@ -32,7 +33,12 @@ class UppASTConsumer : public ASTConsumer {
 
   void HandleTranslationUnit(ASTContext &Ctx) override {}
 
-  bool shouldSkipFunctionBody(Decl *D) override { return true; }
+  // Bodies are only needed to translate accessors, which are methods defined in their class, and
+  // to check that templates can be instantiated.
+  bool shouldSkipFunctionBody(Decl *D) override {
+    if (Quarantine && D->isTemplated()) return false;
+    return !InlineAccessors || !isa<CXXMethodDecl>(D) || !D->getLexicalDeclContext()->isRecord();
+  }
 };
 
 class UppAction : public ASTFrontendAction {
@@ -47,6 +53,12 @@ class UppAction : public ASTFrontendAction {
     CompilerInstance &CI = getCompilerInstance();
     _jm->visitMacros(CI.getPreprocessor());
     _jm->finishTemplates(CI.getSema());
+    _jm->finish();
+
+    const SourceManager &SM = CI.getSourceManager();
+    for (auto it = SM.fileinfo_begin(); it != SM.fileinfo_end(); ++it) {
+      _out.addDependency(it->first->getName().str());
+    }
   }
 
  protected:
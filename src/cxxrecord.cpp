@@ -9,6 +9,8 @@
 #include <clang/AST/DeclTemplate.h>
 #include <clang/AST/RecordLayout.h>
 
+#include <algorithm>
+
 #include "filter.hpp"
 #include "json.hpp"
 #include "options.hpp"
@@ -16,6 +18,9 @@
 using namespace unplusplus;
 using namespace clang;
 
+std::unordered_map<const CXXRecordDecl *, FieldNames> ClassDefineJob::fieldNames;
+std::unordered_set<const ClassTemplateSpecializationDecl *> ClassDefineJob::instantiated;
+
 bool ClassDeclareJob::accept(const type *D) { return getAnonTypedef(D) || !getName(D).empty(); }
 
 ClassDeclareJob::ClassDeclareJob(ClassDeclareJob::type *D, clang::Sema &S, JobManager &jm)
@@ -33,8 +38,7 @@ ClassDeclareJob::ClassDeclareJob(ClassDeclareJob::type *D, clang::Sema &S, JobMa
 }
 
 void ClassDeclareJob::impl() {
-  _out.hf() << "// " << _location << "\n";
-  _out.hf() << "// " << _name << "\n";
+  writeComment(_location);
 
   std::string keyword;
   if (_d->isUnion())
@@ -54,7 +58,7 @@ void ClassDeclareJob::impl() {
   j[jcfg()._cname] = i.c;
   j[jcfg()._qname] = jcfg().jsonQName(_d);
   j[jcfg()._location] = _location;
-  _out.json()[jcfg()._class][i.cpp] = j;
+  _out.jsonEntry(jcfg()._class, i.cpp) = j;
 }
 
 SuperclassVisitor::SuperclassVisitor(Visitor F, const clang::CXXRecordDecl *D, Visitor H)
@@ -169,6 +173,37 @@ void ClassDefineJob::FieldInfo::adjustNames(DiamondRenamer &DR, const Identifier
   }
 }
 
+// Instantiate the definitions of the members, so the ones that don't compile for these template
+// arguments can be excluded before their stubs fail to compile.
+static void quarantineMembers(ClassTemplateSpecializationDecl *CTSD, const IdentifierConfig &cfg,
+                              Sema &S) {
+  DiagnosticsEngine &DE = S.getDiagnostics();
+  // The errors are expected. Suppressed errors are still seen by the traps, but they aren't
+  // counted by the engine, so they don't fail the run or reach the error limit.
+  bool suppressed = DE.getSuppressAllDiagnostics();
+  DE.setSuppressAllDiagnostics(true);
+
+  for (auto *D : CTSD->decls()) {
+    auto *FD = dyn_cast<FunctionDecl>(D);
+    if (!FD || FD->isDeleted() || FD->isDefined()) continue;
+    const FunctionDecl *pattern = FD->getTemplateInstantiationPattern();
+    if (!pattern || !pattern->isDefined()) continue;
+
+    // An explicit instantiation declaration would prevent instantiating the definition
+    TemplateSpecializationKind TSK = FD->getTemplateSpecializationKind();
+    FD->setTemplateSpecializationKind(TSK_ImplicitInstantiation);
+    DiagnosticErrorTrap trap(DE);
+    S.InstantiateFunctionDefinition(CTSD->getLocation(), FD, true);
+    FD->setTemplateSpecializationKind(TSK);
+    if (trap.hasErrorOccurred()) {
+      if (Verbose) std::cout << "Quarantined " << cfg.getDebugName(FD) << std::endl;
+      cfg._df.quarantine(FD, "failed to instantiate");
+    }
+  }
+
+  DE.setSuppressAllDiagnostics(suppressed);
+}
+
 bool ClassDefineJob::accept(type *D, const IdentifierConfig &cfg, Sema &S) {
   auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(D);
   // If an explicit specialiation already appeared, it may be that it was put there to create a
@@ -183,6 +218,8 @@ bool ClassDefineJob::accept(type *D, const IdentifierConfig &cfg, Sema &S) {
     TemplateSpecializationKind TSK = TSK_ExplicitInstantiationDeclaration;
     if (!S.InstantiateClassTemplateSpecialization(L, CTSD, TSK, true)) {
       S.InstantiateClassTemplateSpecializationMembers(L, CTSD, TSK);
+      instantiated.emplace(CTSD);
+      if (Quarantine) quarantineMembers(CTSD, cfg, S);
     } else {
       std::cerr << "Error: Couldn't instantiate " << cfg.getDebugName(D) << std::endl;
     }
@@ -224,9 +261,155 @@ ClassDefineJob::ClassDefineJob(ClassDefineJob::type *D, clang::Sema &S, JobManag
     }
   }
 
+  findContiguous();
+  findIterable();
+
   checkReady();
 }
 
+void ClassDefineJob::findContiguous() {
+  const auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(_d);
+  if (!CTSD || !_d->isInStdNamespace()) return;
+  std::string name = getName(_d);
+  if (name != "vector" && name != "array" && name != "basic_string") return;
+  const TemplateArgumentList &args = CTSD->getTemplateArgs();
+  if (args.size() < 1 || args[0].getKind() != TemplateArgument::Type) return;
+  QualType elem = args[0].getAsType().getCanonicalType();
+  const ASTContext &AC = _d->getASTContext();
+  // std::vector<bool> has no storage to point at, and only trivial types can be copied in bulk
+  if (elem->isBooleanType() && name == "vector") return;
+  if (!elem.isTriviallyCopyableType(AC)) return;
+  if (const auto *RD = elem->getAsRecordDecl()) {
+    if (manager().filter().filterOut(RD)) return;
+  }
+  _contiguous = elem;
+  depends(AC.getPointerType(_contiguous), false);
+}
+
+void ClassDefineJob::writeContiguous(const Identifier &i, Json::Value &j) {
+  const ASTContext &AC = _d->getASTContext();
+  bool fixed = getName(_d) == "array";
+  QualType elemPtr = AC.getPointerType(_contiguous);
+  QualType constElemPtr = AC.getPointerType(_contiguous.withConst());
+  QualType thisPtr = AC.getPointerType(AC.getRecordType(_d));
+  QualType constThisPtr = AC.getPointerType(AC.getRecordType(_d).withConst());
+  Identifier sizet(AC.getSizeType(), Identifier("length"), cfg());
+  Identifier sizetp(AC.getPointerType(AC.getSizeType()), Identifier("length"), cfg());
+  Identifier sizer(AC.getSizeType(), Identifier(), cfg());
+  Identifier self(thisPtr, Identifier(cfg()._this), cfg());
+  Identifier cself(constThisPtr, Identifier(cfg()._this), cfg());
+
+  std::string prefix = i.c + cfg().c_separator;
+  Identifier span(elemPtr, Identifier(prefix + "span(" + self.c + ", " + sizetp.c + ")"), cfg());
+  _out.hf() << "// Contiguous storage of " << i.cpp << "\n";
+  exportFunction(prefix + "span", span.c);
+  _out.sf() << "// Contiguous storage of " << i.cpp << "\n";
+  _out.sf() << span.c << " {\n";
+  _out.sf() << "  *length = " << cfg()._this << "->size();\n";
+  _out.sf() << "  return " << cfg()._this << "->data();\n}\n\n";
+
+  Identifier dst(elemPtr, Identifier("dst"), cfg());
+  std::string copyTo =
+      sizer.c + " " + prefix + "copy_to(" + cself.c + ", " + dst.c + ", " + sizet.c + ")";
+  exportFunction(prefix + "copy_to", copyTo);
+  _out.sf() << copyTo << " {\n";
+  _out.sf() << "  if (length > " << cfg()._this << "->size()) length = " << cfg()._this
+            << "->size();\n";
+  _out.sf() << "  std::copy_n(" << cfg()._this << "->data(), length, dst);\n";
+  _out.sf() << "  return length;\n}\n\n";
+
+  Identifier src(constElemPtr, Identifier("src"), cfg());
+  std::string assignFrom =
+      sizer.c + " " + prefix + "assign_from(" + self.c + ", " + src.c + ", " + sizet.c + ")";
+  exportFunction(prefix + "assign_from", assignFrom);
+  _out.hf() << "\n";
+  _out.sf() << assignFrom << " {\n";
+  if (fixed) {
+    // a std::array can't be resized
+    _out.sf() << "  if (length > " << cfg()._this << "->size()) length = " << cfg()._this
+              << "->size();\n";
+    _out.sf() << "  std::copy_n(src, length, " << cfg()._this << "->data());\n";
+  } else {
+    _out.sf() << "  " << cfg()._this << "->assign(src, src + length);\n";
+  }
+  _out.sf() << "  return length;\n}\n\n";
+
+  j[jcfg()._contiguous] = jcfg().jsonType(_contiguous);
+}
+
+void ClassDefineJob::findIterable() {
+  static const std::unordered_set<std::string> containers = {
+      "array", "vector", "deque", "list", "forward_list", "set", "multiset", "unordered_set",
+      "unordered_multiset", "map", "multimap", "unordered_map", "unordered_multimap"};
+  static const std::unordered_set<std::string> keyed = {"set", "multiset", "unordered_set",
+                                                        "unordered_multiset"};
+  if (!isa<ClassTemplateSpecializationDecl>(_d) || !_d->isInStdNamespace()) return;
+  std::string name = getName(_d);
+  if (!containers.count(name)) return;
+  const ASTContext &AC = _d->getASTContext();
+  const TypedefNameDecl *TD = nullptr;
+  for (auto *d : _d->lookup(&AC.Idents.get("value_type"))) {
+    if ((TD = dyn_cast<TypedefNameDecl>(d))) break;
+  }
+  if (!TD) return;
+  QualType elem = TD->getUnderlyingType().getCanonicalType();
+  // std::vector<bool> hands out proxies instead of references to its elements
+  if (elem->isBooleanType() && name == "vector") return;
+  if (const auto *RD = elem->getAsRecordDecl()) {
+    if (manager().filter().filterOut(RD)) return;
+  }
+  // The elements of a set are its keys, so they can't be modified
+  if (keyed.count(name)) elem.addConst();
+  _iterable = elem;
+  depends(AC.getPointerType(_iterable), false);
+}
+
+void ClassDefineJob::writeIterable(const Identifier &i, Json::Value &j) {
+  const ASTContext &AC = _d->getASTContext();
+  QualType elemPtr = AC.getPointerType(_iterable);
+  QualType fnType = AC.getFunctionType(AC.IntTy, {AC.VoidPtrTy, elemPtr},
+                                       FunctionProtoType::ExtProtoInfo());
+  QualType thisPtr = AC.getPointerType(AC.getRecordType(_d));
+  Identifier self(thisPtr, Identifier(cfg()._this), cfg());
+  Identifier fn(AC.getPointerType(fnType), Identifier("fn"), cfg());
+  Identifier ctx(AC.VoidPtrTy, Identifier("ctx"), cfg());
+  Identifier sizer(AC.getSizeType(), Identifier(), cfg());
+  Identifier first(AC.getSizeType(), Identifier("first"), cfg());
+  Identifier last(AC.getSizeType(), Identifier("last"), cfg());
+  std::string prefix = sizer.c + " " + i.c + cfg().c_separator;
+
+  std::string forEach = prefix + "for_each(" + self.c + ", " + fn.c + ", " + ctx.c + ")";
+  _out.hf() << "// Iteration over the elements of " << i.cpp << "\n";
+  exportFunction(i.c + cfg().c_separator + "for_each", forEach);
+  _out.sf() << "// Iteration over the elements of " << i.cpp << "\n";
+  _out.sf() << forEach << " {\n";
+  _out.sf() << "  size_t count = 0;\n";
+  _out.sf() << "  for (auto &elem : *" << cfg()._this << ") {\n";
+  _out.sf() << "    count++;\n";
+  _out.sf() << "    if (fn(ctx, std::addressof(elem))) break;\n";
+  _out.sf() << "  }\n";
+  _out.sf() << "  return count;\n}\n\n";
+
+  std::string forEachRange = prefix + "for_each_range(" + self.c + ", " + first.c + ", " +
+                             last.c + ", " + fn.c + ", " + ctx.c + ")";
+  exportFunction(i.c + cfg().c_separator + "for_each_range", forEachRange);
+  _out.hf() << "\n";
+  _out.sf() << forEachRange << " {\n";
+  _out.sf() << "  size_t size = std::distance(" << cfg()._this << "->begin(), " << cfg()._this
+            << "->end());\n";
+  _out.sf() << "  if (last > size) last = size;\n";
+  _out.sf() << "  if (first >= last) return 0;\n";
+  _out.sf() << "  auto it = std::next(" << cfg()._this << "->begin(), first);\n";
+  _out.sf() << "  size_t count = 0;\n";
+  _out.sf() << "  for (; first + count < last; ++it) {\n";
+  _out.sf() << "    count++;\n";
+  _out.sf() << "    if (fn(ctx, std::addressof(*it))) break;\n";
+  _out.sf() << "  }\n";
+  _out.sf() << "  return count;\n}\n\n";
+
+  j[jcfg()._iterable] = jcfg().jsonType(_iterable);
+}
+
 void ClassDefineJob::findFields() {
   if (!_d->hasDefinition() || !_d->isCompleteDefinition()) return;
   if (_fields.subFields.size()) return;
@@ -312,8 +495,49 @@ void ClassDefineJob::addFields(const clang::CXXRecordDecl *d, const ClassList pa
   }
 }
 
+uint64_t ClassDefineJob::baseOffset(ClassList &path) {
+  const ASTContext &AC = _d->getASTContext();
+  uint64_t offset = 0;
+  for (size_t i = 1; i < path.size(); i++) {
+    const CXXRecordDecl *D = path[i - 1];
+    bool isVirtual = false;
+    for (const auto &base : D->bases()) {
+      if (base.getType()->getAsCXXRecordDecl() == path[i]) isVirtual = base.isVirtual();
+    }
+    // virtual bases are placed by the most derived class
+    if (isVirtual)
+      offset = AC.toBits(AC.getASTRecordLayout(_d).getVBaseClassOffset(path[i]));
+    else
+      offset += AC.toBits(AC.getASTRecordLayout(D).getBaseClassOffset(path[i]));
+  }
+  return offset;
+}
+
+uint64_t ClassDefineJob::fieldAlign(const FieldInfo &f, uint64_t offset) {
+  const ASTContext &AC = _d->getASTContext();
+  if (f.field && f.field->isBitField()) return 0;
+  const RecordDecl *owner = f.field ? f.field->getParent() : nullptr;
+  bool packed = owner && (owner->hasAttr<PackedAttr>() || f.field->hasAttr<PackedAttr>());
+
+  // alignas on the field, or an aligned typedef or record that the mirror type lost
+  uint64_t align = f.field ? f.field->getMaxAlignment() : 0;
+  if (f.field && !packed) align = std::max(align, AC.getTypeAlign(f.field->getType()));
+  // The first field of an explicitly aligned class carries the class' alignment
+  for (const auto *P : f.parents) {
+    if (!P->getMaxAlignment() || _aligned.count(P)) continue;
+    _aligned.emplace(P);
+    if (offset % P->getMaxAlignment() == 0) align = std::max<uint64_t>(align, P->getMaxAlignment());
+  }
+  if (owner) {
+    if (const auto *MFA = owner->getAttr<MaxFieldAlignmentAttr>())
+      align = std::min<uint64_t>(align, MFA->getAlignment());
+  }
+  return align > AC.getTypeAlign(f.type) ? align : 0;
+}
+
 void ClassDefineJob::writeFields(FieldInfo &list, Json::Value &j, std::string indent,
-                                 std::unordered_set<std::string> *names) {
+                                 std::unordered_set<std::string> *names, int64_t base,
+                                 const std::string &prefix) {
   const ASTContext &AC = _d->getASTContext();
   std::unique_ptr<std::unordered_set<std::string>> mynames;
   if (!names) {
@@ -336,24 +560,51 @@ void ClassDefineJob::writeFields(FieldInfo &list, Json::Value &j, std::string in
     fj[jcfg()._union] = f.isUnion;
     if (f.name.size()) fj[jcfg()._fieldName] = f.name;
 
+    // Fields of anonymous structs and unions are relative to the field holding them
+    uint64_t offset = base < 0 ? baseOffset(f.parents) : base;
+    if (f.field) offset += AC.getFieldOffset(f.field);
+    std::string designator = f.name.size() ? prefix + f.name : "";
+    if (f.field && designator.size() && !f.subFields.size()) {
+      // a field reached twice through multiple inheritance can't be named unambiguously
+      FieldNames &fn = fieldNames[_d];
+      fn[f.field] = fn.count(f.field) ? "" : designator;
+    }
+    if (f.field && f.field->isBitField()) {
+      fj[jcfg()._bitOffset] = Json::UInt64(offset);
+    } else {
+      fj[jcfg()._offset] = Json::UInt64(AC.toCharUnitsFromBits(offset).getQuantity());
+      if (designator.size() && !f.subFields.size())
+        _offsets.emplace_back(designator, AC.toCharUnitsFromBits(offset).getQuantity());
+    }
+
     if (f.subFields.size()) {
+      const RecordDecl *RD = f.type->getAsRecordDecl();
+      std::string packed = RD && RD->hasAttr<PackedAttr>() ? cfg()._packed + " " : "";
       if (f.isUnion)
-        _out.hf() << indent << "union {\n";
+        _out.hf() << indent << "union " << packed << "{\n";
       else
-        _out.hf() << indent << "struct {\n";
+        _out.hf() << indent << "struct " << packed << "{\n";
       Json::Value sj(Json::ValueType::arrayValue);
-      writeFields(f, sj, indent + "  ", f.name.empty() ? names : nullptr);
+      writeFields(f, sj, indent + "  ", f.name.empty() ? names : nullptr, offset,
+                  designator.size() ? designator + "." : prefix);
       _out.hf() << indent << "}";
       if (f.name.size()) _out.hf() << " " << fi.c;
       _out.hf() << ";\n";
       fj[jcfg()._fields] = sj;
     } else {
-      _out.hf() << indent << fi.c;
+      _out.hf() << indent;
+      if (uint64_t align = fieldAlign(f, offset)) {
+        _out.hf() << cfg()._alignas << "(" << AC.toCharUnitsFromBits(align).getQuantity() << ") ";
+        fj[jcfg()._align] = Json::Int64(AC.toCharUnitsFromBits(align).getQuantity());
+      }
+      _out.hf() << fi.c;
       if (f.field && f.field->isBitField()) {
         unsigned bits = f.field->getBitWidthValue(AC);
         _out.hf() << " : " << bits;
         fj[jcfg()._fieldBits] = bits;
       }
+      if (f.field && f.field->hasAttr<PackedAttr>() && !f.field->getParent()->hasAttr<PackedAttr>())
+        _out.hf() << " " << cfg()._packed;
       Decl *LocD = f.field ? (Decl *)f.field : (Decl *)f.parents.back();
       std::string location = LocD->getLocation().printToString(AC.getSourceManager());
       _out.hf() << "; // ";
@@ -372,8 +623,7 @@ void ClassDefineJob::writeFields(FieldInfo &list, Json::Value &j, std::string in
 
 void ClassDefineJob::impl() {
   const ASTContext &AC = _d->getASTContext();
-  _out.hf() << "// " << _location << "\n";
-  _out.hf() << "// " << _name << "\n";
+  writeComment(_location);
 
   std::string keyword;
   if (_d->isUnion())
@@ -382,37 +632,93 @@ void ClassDefineJob::impl() {
     keyword = "struct";
 
   Identifier i(_d, cfg());
-  Json::Value &j = _out.json()[jcfg()._class][i.cpp];
+  // The entry is only updated once the definition is complete, in case the job fails
+  Json::Value j = _out.json()[jcfg()._class].get(i.cpp, Json::Value(Json::ValueType::objectValue));
   j[jcfg()._union] = _d->isUnion();
   j[jcfg()._fields] = Json::Value(Json::ValueType::arrayValue);
-  _out.hf() << keyword << " " << i.c << cfg()._struct << " {\n";
+  // #pragma pack limits the alignment of the fields, __attribute__((packed)) removes it
+  const auto *MFA = _d->getAttr<MaxFieldAlignmentAttr>();
+  if (MFA) {
+    uint64_t pack = AC.toCharUnitsFromBits(MFA->getAlignment()).getQuantity();
+    _out.hf() << "#pragma pack(push, " << pack << ")\n";
+    j[jcfg()._maxFieldAlign] = Json::UInt64(pack);
+  }
+  j[jcfg()._packed] = _d->hasAttr<PackedAttr>();
+  _out.hf() << keyword << " " << (_d->hasAttr<PackedAttr>() ? cfg()._packed + " " : "") << i.c
+            << cfg()._struct << " {\n";
+  _aligned.clear();
   writeFields(_fields, j[jcfg()._fields]);
   _out.hf() << "};\n";
+  if (MFA) _out.hf() << "#pragma pack(pop)\n";
+
+  CharUnits size = AC.getTypeSizeInChars(_d->getTypeForDecl());
+  j[jcfg()._size] = Json::Int64(size.getQuantity());
+  CharUnits align = AC.getTypeAlignInChars(_d->getTypeForDecl());
+  j[jcfg()._align] = Json::Int64(align.getQuantity());
 
+  // The field offsets are checked too, so an FFI can rely on them to access fields directly
+  std::string mirror = keyword + " " + i.c + cfg()._struct;
+  if (_offsets.size()) _out.addCHeader("stddef.h");
   _out.hf() << "#ifdef __cplusplus\n";
-  _out.hf() << "static_assert(sizeof(" << keyword << " " << i.c << cfg()._struct << ") == sizeof("
-            << i.cpp << "), \"Size of C struct must match C++\");\n";
+  _out.hf() << "static_assert(sizeof(" << mirror << ") == sizeof(" << i.cpp
+            << "), \"Size of C struct must match C++\");\n";
+  _out.hf() << "static_assert(alignof(" << mirror << ") == alignof(" << i.cpp
+            << "), \"Alignment of C struct must match C++\");\n";
+  for (auto &o : _offsets) {
+    _out.hf() << "static_assert(offsetof(" << mirror << ", " << o.first << ") == " << o.second
+              << ", \"Offset of C field must match C++\");\n";
+  }
   _out.hf() << "#else\n";
-  _out.hf() << "_Static_assert(sizeof(" << keyword << " " << i.c << cfg()._struct
-            << ") == " << _d->getASTContext().getTypeSizeInChars(_d->getTypeForDecl()).getQuantity()
+  _out.hf() << "_Static_assert(sizeof(" << mirror << ") == " << size.getQuantity()
             << ", \"Size of C struct must match C++\");\n";
+  _out.hf() << "_Static_assert(_Alignof(" << mirror << ") == " << align.getQuantity()
+            << ", \"Alignment of C struct must match C++\");\n";
+  for (auto &o : _offsets) {
+    _out.hf() << "_Static_assert(offsetof(" << mirror << ", " << o.first << ") == " << o.second
+              << ", \"Offset of C field must match C++\");\n";
+  }
   _out.hf() << "#endif\n\n";
 
+  // The mirror struct is shared by all the parts of a split header, but its functions aren't
+  _out.setPartition(partitionOf(_d));
   if (!_no_ctor && _d->hasDefaultConstructor()) {
     std::string name = i.c;
     name.insert(cfg()._root.size(), cfg()._ctor + "array_");
     Identifier sizet(_d->getASTContext().getSizeType(), Identifier("length"), cfg());
+    std::string signature = i.c + " *" + name + "(" + sizet.c + ")";
     _out.hf() << "// Array constructor of " << i.cpp << "\n";
     _out.sf() << "// Array constructor of " << i.cpp << "\n";
-    _out.hf() << i.c << " *" << name << "(" << sizet.c << ");\n\n";
-    _out.sf() << i.c << " *" << name << "(" << sizet.c << ") {\n";
+    exportFunction(name, signature);
+    _out.hf() << "\n";
+    _out.sf() << signature << " {\n";
     _out.sf() << "  return new " << i.cpp << "[length];\n}\n\n";
     name = i.c;
     name.insert(cfg()._root.size(), cfg()._dtor + "array_");
+    signature = "void " + name + "(" + i.c + " *" + cfg()._this + ")";
     _out.hf() << "// Array destructor of " << i.cpp << "\n";
     _out.sf() << "// Array destructor of " << i.cpp << "\n";
-    _out.hf() << "void " << name << "(" << i.c << " *" << cfg()._this << ");\n\n";
-    _out.sf() << "void " << name << "(" << i.c << " *" << cfg()._this << ") {\n";
+    exportFunction(name, signature);
+    _out.hf() << "\n";
+    _out.sf() << signature << " {\n";
     _out.sf() << "  delete[] " << cfg()._this << ";\n}\n\n";
   }
+
+  if (!_contiguous.isNull()) writeContiguous(i, j);
+  if (!_iterable.isNull()) writeIterable(i, j);
+
+  // Objects returned by value are constructed in storage the caller owns, so they need to be
+  // destroyed without being freed.
+  const CXXDestructorDecl *DD = _d->getDestructor();
+  if (DD && !DD->isDeleted() && DD->getAccess() == AccessSpecifier::AS_public) {
+    std::string name = i.c;
+    name.insert(cfg()._root.size(), cfg()._destroy);
+    std::string signature = "void " + name + "(" + i.c + " *" + cfg()._this + ")";
+    _out.hf() << "// In-place destructor of " << i.cpp << "\n";
+    _out.sf() << "// In-place destructor of " << i.cpp << "\n";
+    exportFunction(name, signature);
+    _out.hf() << "\n";
+    _out.sf() << signature << " {\n";
+    _out.sf() << "  std::destroy_at(" << cfg()._this << ");\n}\n\n";
+  }
+  _out.jsonEntry(jcfg()._class, i.cpp) = j;
 }
@@ -31,8 +31,7 @@ void EnumJob::impl() {
   }
   // now, field i.c should be empty only if there really is no name available.
 
-  _out.hf() << "// " << _location << "\n";
-  _out.hf() << "// " << _name << "\n";
+  writeComment(_location);
 
   // try to figure _out if C will have the correct type for the enum.
 
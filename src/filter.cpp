@@ -7,6 +7,7 @@
 
 #include <clang/AST/DeclTemplate.h>
 #include <clang/Basic/SourceManager.h>
+#include <llvm/Support/Path.h>
 
 #include <fstream>
 #include <iostream>
@@ -126,10 +127,8 @@ bool unplusplus::traverse(const Decl *D, std::function<bool(const clang::Decl *)
   }
 }
 
-static const SrcMgr::SLocEntry *getSEntry(const clang::Decl *D) {
-  SourceLocation loc = D->getLocation();
+static const SrcMgr::SLocEntry *getSEntry(SourceLocation loc, const SourceManager &SM) {
   while (true) {
-    SourceManager &SM = D->getASTContext().getSourceManager();
     FileID FID = SM.getFileID(SM.getFileLoc(loc));
     bool Invalid = false;
     const SrcMgr::SLocEntry *SEntry = &SM.getSLocEntry(FID, &Invalid);
@@ -149,6 +148,10 @@ static const SrcMgr::SLocEntry *getSEntry(const clang::Decl *D) {
   }
 }
 
+static const SrcMgr::SLocEntry *getSEntry(const clang::Decl *D) {
+  return getSEntry(D->getLocation(), D->getASTContext().getSourceManager());
+}
+
 std::string unplusplus::getDeclHeader(const clang::Decl *D) {
   auto *SEntry = getSEntry(D);
   if (SEntry)
@@ -200,6 +203,13 @@ bool DeclFilter::filterOut(const clang::Decl *D) {
   return _cache[D];
 }
 
+void DeclFilter::quarantine(const clang::Decl *D, const std::string &reason) {
+  std::string name = getCXXQualifiedName(_pp, D);
+  if (!_excluded.count(name)) _quarantined.emplace_back(name, reason);
+  _excluded.emplace(name);
+  _cache[D] = true;
+}
+
 void DeclFilter::sanitizeType(QualType &QT, const ASTContext &AC) {
   if (QT->isRecordType()) {
     if (!QT->getAsRecordDecl()->isCompleteDefinition() || filterOut(QT->getAsRecordDecl())) {
@@ -221,6 +231,26 @@ void DeclFilter::sanitizeType(QualType &QT, const ASTContext &AC) {
   }
 }
 
+bool DeclFilter::isWrappedHeader(clang::SourceLocation L, const clang::SourceManager &SM) {
+  auto *SEntry = getSEntry(L, SM);
+  if (!SEntry) return false;
+
+  std::string header = SEntry->getFile().getName().str();
+  if (_wrapped.count(header)) {
+    return _wrapped.at(header);
+  }
+  const FileEntry *main = SM.getFileEntryForID(SM.getMainFileID());
+  bool match = false;
+  if (main && !SrcMgr::isSystem(SEntry->getFile().getFileCharacteristic())) {
+    std::string dir = llvm::sys::path::parent_path(main->getName()).str();
+    match = header == main->getName() || dir.empty() ||
+            (header.size() > dir.size() && header.compare(0, dir.size(), dir) == 0 &&
+             llvm::sys::path::is_separator(header[dir.size()]));
+  }
+  _wrapped[header] = match;
+  return match;
+}
+
 bool DeclFilter::matchHeader(std::string &S) {
   for (auto &p : _headerPatterns) {
     if (S.find(p) == S.size() - p.size()) {
@@ -235,26 +265,27 @@ bool DeclFilter::isCHeader(const clang::Decl *D) {
   if (_cheaderd.count(D)) {
     return _cheaderd.at(D);
   }
-  std::string qname = getCXXQualifiedName(_pp, D);
+  bool match = isCHeader(D->getLocation(), D->getASTContext().getSourceManager());
+  _cheaderd[D] = match;
+  return match;
+}
 
-  auto *SEntry = getSEntry(D);
+bool DeclFilter::isCHeader(clang::SourceLocation L, const clang::SourceManager &SM) {
+  auto *SEntry = getSEntry(L, SM);
   if (!SEntry)
     return false;
 
   std::string header = SEntry->getFile().getName().str();
   if (_cheader.count(header)) {
-    _cheaderd[D] = _cheader.at(header);
     return _cheader.at(header);
   }
   SrcMgr::CharacteristicKind ck = SEntry->getFile().getFileCharacteristic();
   if (ck == SrcMgr::CharacteristicKind::C_ExternCSystem) {
-    _cheaderd[D] = true;
     _cheader[header] = true;
     return true;
   }
 
   bool match = matchHeader(header);
-  _cheaderd[D] = match;
   _cheader[header] = match;
   return match;
 }
@@ -5,30 +5,137 @@
 
 #include "function.hpp"
 
+#include <clang/AST/RecordLayout.h>
+#include <clang/AST/VTableBuilder.h>
+#include <clang/Basic/TargetInfo.h>
+#include <llvm/Support/Regex.h>
+#include <llvm/Support/raw_os_ostream.h>
+
+#include "accessor.hpp"
+#include "cxxrecord.hpp"
+#include "options.hpp"
+
 using namespace clang;
 using namespace unplusplus;
 
+// Records larger than this are still passed by pointer, even if they could be passed by value.
+static const uint64_t MAX_BY_VALUE_BYTES = 32;
+
 bool FunctionJob::accept(const type *D) {
   bool extc = D->isExternC() || D->isInExternCContext();
   return !D->isTemplated() && !D->isDeleted() && !D->isDeletedAsWritten() &&
          (extc || !D->isVariadic());
 }
 
+bool FunctionJob::wantsBatch() {
+  static std::vector<llvm::Regex> patterns = [] {
+    std::vector<llvm::Regex> result;
+    for (const auto &p : BatchPatterns) result.emplace_back(p);
+    return result;
+  }();
+  if (patterns.empty()) return false;
+  std::vector<std::string> names = {cfg().getCXXQualifiedName(_d)};
+  if (const auto *M = dyn_cast<CXXMethodDecl>(_d))
+    names.push_back(cfg().getCXXQualifiedName(M->getParent()));
+  for (auto &p : patterns) {
+    for (const auto &n : names) {
+      if (p.match(n)) return true;
+    }
+  }
+  return false;
+}
+
+QualType FunctionJob::bridgedElement(QualType QT, bool &owned) {
+  const auto *CTSD = dyn_cast_or_null<ClassTemplateSpecializationDecl>(QT->getAsCXXRecordDecl());
+  if (!CTSD || !CTSD->isInStdNamespace()) return QualType();
+  const TemplateArgumentList &args = CTSD->getTemplateArgs();
+  if (args.size() < 1 || args[0].getKind() != TemplateArgument::Type) return QualType();
+  QualType elem = args[0].getAsType().getCanonicalType();
+  std::string name = getName(CTSD);
+  owned = name == "basic_string";
+  if (owned || name == "basic_string_view") return elem.withConst();
+  // only a std::span with a dynamic extent can be made from any pointer and length
+  if (name == "span" && args.size() > 1 && args[1].getKind() == TemplateArgument::Integral &&
+      args[1].getAsIntegral().isMaxValue())
+    return elem;
+  return QualType();
+}
+
+// Whether the mirror struct has a char array or member where the class has a record, which the ABI
+// classifies differently.
+static bool hasPlaceholder(const CXXRecordDecl *RD, DeclFilter &DF) {
+  for (const auto &B : RD->bases()) {
+    const auto *BD = B.getType()->getAsCXXRecordDecl();
+    // empty bases add nothing to the mirror struct, or to how the class is passed
+    if (!BD || (!BD->isEmpty() && hasPlaceholder(BD, DF))) return true;
+  }
+  for (const auto *F : RD->fields()) {
+    QualType QT = F->getType();
+    while (const ArrayType *AT = QT->getAsArrayTypeUnsafe()) QT = AT->getElementType();
+    const auto *FD = QT->getAsCXXRecordDecl();
+    if (!FD) continue;
+    if (!FD->isCompleteDefinition() || FD->isEmpty() || DF.filterOut(FD)) return true;
+    if (hasPlaceholder(FD, DF)) return true;
+  }
+  return false;
+}
+
+bool FunctionJob::byValue(QualType QT) {
+  CXXRecordDecl *RD = QT->getAsCXXRecordDecl();
+  if (!RD) return false;
+  // There has to be a mirror struct for C to see the value. Creating it first can complete the
+  // class, so the signature doesn't depend on the order declarations were found in.
+  manager().create(QT, _s);
+  if (!RD->isCompleteDefinition() || RD->isDependentType()) return false;
+  const ASTContext &AC = _d->getASTContext();
+  // The type must be passed the same way as a C struct would be by the ABI. Other C++ ABIs, like
+  // Microsoft's, can return trivially copyable classes differently from C structs.
+  if (!AC.getTargetInfo().getCXXABI().isItaniumFamily()) return false;
+  if (!RD->isTriviallyCopyable() || !RD->canPassInRegisters()) return false;
+  // Empty classes are ignored as arguments, but their mirror struct has a placeholder member
+  if (RD->isEmpty() || hasPlaceholder(RD, manager().filter())) return false;
+  if (AC.getTypeSizeInChars(QT).getQuantity() > MAX_BY_VALUE_BYTES) return false;
+  return manager().isDefined(RD);
+}
+
 FunctionJob::FunctionJob(FunctionJob::type *D, clang::Sema &S, JobManager &jm)
     : Job<FunctionJob::type>(D, S, jm) {
   manager().declare(_d, this);
+  _partition = partitionOf(_d);
   if (auto *l = _d->getTemplateSpecializationArgs()) {
     manager().lazyCreate(_d->getDescribedFunctionTemplate(), S);
     manager().lazyCreate(l->asArray(), S);
   }
 
-  _returnType = _d->getReturnType();
-  _returnParam = _returnType->isRecordType() || _returnType->isReferenceType();
-  if (_returnParam) _returnType = _d->getASTContext().VoidTy;
   const auto &AC = _d->getASTContext();
+  bool extc = _d->isExternC() || _d->isInExternCContext();
+  bool bridged = false;
+  _returnType = _d->getReturnType();
+  if (!extc) {
+    // Strings and views are returned as a pointer to the characters and a length. An owned string
+    // is copied to the buffer supplied by the caller, and the total length is returned.
+    bool owned = false;
+    QualType RT = _returnType.getNonReferenceType();
+    QualType elem = bridgedElement(RT, owned);
+    bool view = _returnType->isReferenceType()
+                    ? _returnType->isLValueReferenceType() && RT.isConstQualified() && owned
+                    : !owned;
+    if (!elem.isNull() && !_returnType->isReferenceType() && owned) {
+      _returnBuffer = true;
+      _returnSpan = AC.getPointerType(elem.getUnqualifiedType());
+      _returnType = AC.getSizeType();
+    } else if (!elem.isNull() && view) {
+      _returnSpan = AC.getPointerType(elem);
+      _returnType = _returnSpan;
+    }
+    bridged = !_returnSpan.isNull();
+  }
+  _returnConstruct = _returnType->isRecordType() && !byValue(_returnType);
+  _returnParam = _returnConstruct || _returnType->isReferenceType();
+  if (_returnParam) _returnType = AC.VoidTy;
   if (auto *Ctor = dyn_cast<CXXConstructorDecl>(_d))
     _returnType = AC.getPointerType(AC.getRecordType(Ctor->getParent()));
-  depends(_returnType, false);
+  depends(_returnType, _returnType->isRecordType());
 
   if (_returnParam) {
     _returnParamType = _d->getReturnType().getDesugaredType(_d->getASTContext());
@@ -42,12 +149,29 @@ FunctionJob::FunctionJob(FunctionJob::type *D, clang::Sema &S, JobManager &jm)
     }
     depends(_returnParamType, false);
   }
+  // The stub's own copies and conversions can throw, even if the function can't. A referenced
+  // result is copied into the caller's object.
+  bool throwing = _returnParam && !_returnConstruct &&
+                  !_returnParamType->getPointeeType().isTriviallyCopyableType(AC);
 
   _paramTypes.resize(_d->getNumParams());
   _paramDeref.resize(_d->getNumParams(), false);
+  _paramSpan.resize(_d->getNumParams());
   for (size_t i = 0; i < _d->getNumParams(); i++) {
     QualType QP(_d->getParamDecl(i)->getType());
-    if (QP->isRecordType()) {
+    bool owned = false;
+    QualType T = QP.getNonReferenceType();
+    QualType elem = extc ? QualType() : bridgedElement(T, owned);
+    if (!elem.isNull() && (!QP->isLValueReferenceType() || T.isConstQualified())) {
+      // the string, view or span is constructed in the stub from a pointer and length
+      _paramSpan[i] = T.getUnqualifiedType();
+      QP = AC.getPointerType(elem);
+      bridged = true;
+      // a string allocates its copy of the characters
+      throwing |= owned;
+    } else if (QP->isRecordType() && !byValue(QP)) {
+      // the argument is copied from the object the pointer points to
+      throwing |= !QP.isTriviallyCopyableType(AC);
       QP = _d->getASTContext().getPointerType(QP);
       _paramDeref[i] = true;
     } else if (QP->isReferenceType()) {
@@ -55,18 +179,407 @@ FunctionJob::FunctionJob(FunctionJob::type *D, clang::Sema &S, JobManager &jm)
       _paramDeref[i] = true;
     }
     _paramTypes[i] = QP;
-    depends(QP, false);
+    depends(QP, QP->isRecordType());
   }
   if (auto *M = dyn_cast<CXXMethodDecl>(_d)) {
     depends(M->getParent(), false);
   }
+
+  // Allocating an object for a constructor can always throw.
+  if (const auto *FPT = _d->getType()->getAs<FunctionProtoType>()) {
+    if (isUnresolvedExceptionSpec(FPT->getExceptionSpecType()))
+      FPT = _s.ResolveExceptionSpec(_d->getLocation(), FPT);
+    _nothrow = FPT && FPT->isNothrow() && !isa<CXXConstructorDecl>(_d) && !throwing;
+  }
+  _translate = TranslateExceptions && !_nothrow && !extc;
+  _batch = !extc && !bridged && !_d->isVariadic() && !isa<CXXConstructorDecl>(_d) &&
+           !isa<CXXDestructorDecl>(_d) && wantsBatch();
+  if (auto *M = dyn_cast<CXXMethodDecl>(_d)) {
+    _inline = !extc && wantsInline(M);
+    // the fields are accessed through the mirror struct
+    if (_inline) depends(M->getParent(), true);
+  }
   checkReady();
 }
 
+void FunctionJob::writeBody(const std::string &block, bool value) {
+  std::string indent = _translate ? "    " : "  ";
+  std::stringstream lines;
+  std::istringstream is(block);
+  std::string line;
+  while (std::getline(is, line)) lines << indent << line << "\n";
+  if (!_translate) {
+    _out.sf() << lines.str();
+    return;
+  }
+  std::string setError = cfg()._root + _out.libName() + cfg().c_separator + "set_error";
+  _out.sf() << "  try {\n";
+  _out.sf() << lines.str();
+  _out.sf() << "  } catch (const std::bad_alloc &e) {\n";
+  _out.sf() << "    " << setError << "(1, e.what());\n";
+  _out.sf() << "  } catch (const std::exception &e) {\n";
+  _out.sf() << "    " << setError << "(2, e.what());\n";
+  _out.sf() << "  } catch (...) {\n";
+  _out.sf() << "    " << setError << "(3, \"unknown exception\");\n";
+  _out.sf() << "  }\n";
+  if (value) _out.sf() << "  return {};\n";
+}
+
+std::string FunctionJob::statement(const std::string &callee, const std::string &call) {
+  const auto *method = dyn_cast<CXXMethodDecl>(_d);
+  bool ctor = isa<CXXConstructorDecl>(_d);
+  bool dtor = isa<CXXDestructorDecl>(_d);
+  std::stringstream stmt;
+  if (dtor) {
+    stmt << "delete " << cfg()._this;
+  } else if (_returnConstruct) {
+    // construct the result directly in the caller's storage, so the copy is elided
+    Identifier rt(_returnParamType->getPointeeType(), Identifier(), cfg());
+    stmt << "new (" << cfg()._return << ") " << rt.cpp << "(" << callee << "(" << call << "))";
+  } else if (_returnParam) {
+    stmt << "*" << cfg()._return << " = " << callee << "(" << call << ")";
+  } else if (_returnBuffer) {
+    std::string len = cfg()._return + cfg()._length;
+    stmt << "auto " << cfg()._result << " = " << callee << "(" << call << ");\n";
+    stmt << "auto _upp_copied = " << cfg()._result << ".copy(" << cfg()._return << ", " << len
+         << ");\n";
+    stmt << "if (_upp_copied < " << len << ") " << cfg()._return << "[_upp_copied] = 0;\n";
+    stmt << "return " << cfg()._result << ".size()";
+  } else if (!_returnSpan.isNull()) {
+    // the view or reference stays valid after the call
+    stmt << "auto &&" << cfg()._result << " = " << callee << "(" << call << ");\n";
+    stmt << "*" << cfg()._return << cfg()._length << " = " << cfg()._result << ".size();\n";
+    stmt << "return " << cfg()._result << ".data()";
+  } else if (ctor) {
+    stmt << "return new " << Identifier(method->getParent(), cfg()).cpp << "(" << call << ")";
+  } else {
+    stmt << "return " << callee << "(" << call << ")";
+  }
+  stmt << ";";
+  return stmt.str();
+}
+
+std::unordered_map<std::string, std::string> FunctionJob::stubs;
+
+// The standard containers whose members only copy the pointers they hold, and never use what they
+// point to, so their code is the same for any type of pointer.
+static bool isPointerAgnostic(const ClassTemplateSpecializationDecl *CTSD) {
+  if (!CTSD->isInStdNamespace()) return false;
+  std::string name = getName(CTSD);
+  return name == "vector" || name == "deque" || name == "list" || name == "forward_list" ||
+         name == "array";
+}
+
+// Print the template argument, with pointers to objects all treated the same.
+static void printErased(std::ostream &os, const TemplateArgument &Arg, const PrintingPolicy &PP) {
+  if (Arg.getKind() == TemplateArgument::Type) {
+    QualType QT = Arg.getAsType().getCanonicalType();
+    const auto *CTSD = dyn_cast_or_null<ClassTemplateSpecializationDecl>(QT->getAsCXXRecordDecl());
+    if (QT->isPointerType() && !QT->isFunctionPointerType()) {
+      os << "void *";
+    } else if (CTSD && CTSD->isInStdNamespace() && getName(CTSD) == "allocator") {
+      // the default allocator of the pointers doesn't use what they point to either
+      os << "std::allocator<";
+      for (const auto &A : CTSD->getTemplateArgs().asArray()) printErased(os, A, PP);
+      os << ">";
+    } else {
+      os << QT.getAsString(PP);
+    }
+  } else if (Arg.getKind() == TemplateArgument::Pack) {
+    for (const auto &A : Arg.pack_elements()) printErased(os, A, PP);
+  } else {
+    llvm::raw_os_ostream ros(os);
+    Arg.print(PP, ros, true);
+  }
+  os << ",";
+}
+
+std::string FunctionJob::aliasKey() {
+  if (!AliasStubs || _d->isVariadic()) return "";
+  const auto *method = dyn_cast<CXXMethodDecl>(_d);
+  if (!method || !_d->getTemplateInstantiationPattern()) return "";
+  // Only instantiations of the primary template are known to share their code
+  const auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(method->getParent());
+  if (!CTSD || CTSD->getSpecializationKind() == TSK_ExplicitSpecialization ||
+      !CTSD->getSpecializedTemplateOrPartial().is<ClassTemplateDecl *>())
+    return "";
+  // Other templates can use what their pointer arguments point to, like calling or deleting it
+  if (!isPointerAgnostic(CTSD)) return "";
+
+  const ASTContext &AC = _d->getASTContext();
+  QualType parent = AC.getRecordType(CTSD);
+  std::stringstream key;
+  key << static_cast<const void *>(_d->getTemplateInstantiationPattern()) << "|"
+      << AC.getTypeSize(parent) << "," << AC.getTypeAlign(parent) << "|";
+  for (const auto &A : CTSD->getTemplateArgs().asArray()) printErased(key, A, cfg().PP);
+  // The C signature must be the same, other than the types that pointers point to
+  key << "|";
+  std::vector<QualType> types = {_returnType, _returnParamType};
+  types.insert(types.end(), _paramTypes.begin(), _paramTypes.end());
+  for (const auto &T : types) {
+    if (T.isNull())
+      key << "-,";
+    else if (T->isPointerType())
+      key << "void *,";
+    else
+      key << T.getCanonicalType().getAsString(cfg().PP) << ",";
+  }
+  return key.str();
+}
+
+std::string FunctionJob::instantiation(const std::string &fname) {
+  const auto *method = dyn_cast<CXXMethodDecl>(_d);
+  if (!method || method->isImplicit() || method->isDefaulted()) return "";
+  const auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(method->getParent());
+  if (!CTSD || !ClassDefineJob::instantiated.count(CTSD)) return "";
+  // Members that are specialized or explicitly instantiated by the library already have their
+  // definition, and a second one would break the one definition rule.
+  if (CTSD->getSpecializationKind() != TSK_ImplicitInstantiation ||
+      method->getTemplateSpecializationKind() != TSK_ImplicitInstantiation)
+    return "";
+  // extern template doesn't stop inline members, like those defined in the class, from being
+  // compiled again, so only members defined out of line are worth instantiating once.
+  const FunctionDecl *pattern = method->getInstantiatedFromMemberFunction();
+  const FunctionDecl *def = nullptr;
+  if (!pattern || !pattern->isDefined(def) || def->isInlined()) return "";
+
+  std::string s;
+  llvm::raw_string_ostream os(s);
+  os << Identifier(CTSD, cfg()).cpp << "::";
+  if (isa<CXXConstructorDecl>(method))
+    os << getName(CTSD);
+  else if (isa<CXXDestructorDecl>(method))
+    os << "~" << getName(CTSD);
+  else
+    os << fname;
+  // The exception specification doesn't need to be repeated
+  os << "(";
+  for (unsigned p = 0; p < method->getNumParams(); ++p) {
+    if (p) os << ", ";
+    method->getParamDecl(p)->getType().getCanonicalType().print(os, cfg().PP);
+  }
+  if (method->isVariadic()) os << (method->getNumParams() ? ", ..." : "...");
+  os << ")";
+  if (method->isConst()) os << " const";
+  if (method->isVolatile()) os << " volatile";
+  if (method->getRefQualifier() == RQ_LValue) os << " &";
+  if (method->getRefQualifier() == RQ_RValue) os << " &&";
+  os.flush();
+
+  if (isa<CXXConstructorDecl>(method) || isa<CXXDestructorDecl>(method) ||
+      isa<CXXConversionDecl>(method))
+    return s;
+  std::string decl;
+  llvm::raw_string_ostream ds(decl);
+  method->getReturnType().getCanonicalType().print(ds, cfg().PP, s);
+  ds.flush();
+  return decl;
+}
+
+// Only arithmetic types are the same in C and C++, and can be made from zero.
+static bool isBenchType(QualType QT) {
+  QT = QT.getCanonicalType();
+  return !QT->isEnumeralType() && (QT->isIntegerType() || QT->isRealFloatingType());
+}
+
+void FunctionJob::addBenchmark(const Identifier &i, const std::string &fname) {
+  if (_returnParam || !_returnSpan.isNull() || _d->isVariadic()) return;
+  if (isa<CXXConstructorDecl>(_d) || isa<CXXDestructorDecl>(_d)) return;
+  if (!_returnType->isVoidType() && !isBenchType(_returnType)) return;
+
+  Benchmark b;
+  b.name = i.c;
+  std::string args;
+  for (unsigned p = 0; p < _d->getNumParams(); ++p) {
+    QualType T = _d->getParamDecl(p)->getType();
+    if (!isBenchType(T)) return;
+    if (p) args += ", ";
+    args += "static_cast<" + Identifier(T, {}, cfg()).cpp + ">(upp_zero)";
+  }
+
+  if (auto *M = dyn_cast<CXXMethodDecl>(_d)) {
+    // The object is value-initialized, so it needs a usable default constructor and destructor
+    CXXRecordDecl *RD = M->getParent();
+    CXXConstructorDecl *DC = RD->isAbstract() ? nullptr : _s.LookupDefaultConstructor(RD);
+    CXXDestructorDecl *DD = RD->getDestructor();
+    if (!DC || DC->isDeleted() || DC->getAccess() != AS_public) return;
+    if (DD && (DD->isDeleted() || DD->getAccess() != AS_public)) return;
+    b.setup = Identifier(RD, cfg()).cpp + " upp_obj{};";
+    b.cpp = "upp_obj." + fname + "(" + args + ")";
+    b.c = i.c + "(&upp_obj" + (args.empty() ? "" : ", ") + args + ")";
+  } else {
+    b.cpp = i.cpp + "(" + args + ")";
+    b.c = i.c + "(" + args + ")";
+  }
+  _out.addBenchmark(b);
+}
+
+bool FunctionJob::wantsInline(CXXMethodDecl *M) {
+  if (!InlineAccessors || isa<CXXConstructorDecl>(M) || isa<CXXDestructorDecl>(M)) return false;
+  // A call of a virtual method may go to an override instead
+  if (M->isVirtual() && !M->hasAttr<FinalAttr>() && !M->getParent()->hasAttr<FinalAttr>())
+    return false;
+  // Only the bodies of methods defined in their class are parsed
+  const FunctionDecl *pattern = M->getTemplateInstantiationPattern();
+  if (!pattern) pattern = M;
+  if (!pattern->doesThisDeclarationHaveABody() ||
+      !pattern->getLexicalDeclContext()->isRecord())
+    return false;
+  if (!M->hasBody() && M->isImplicitlyInstantiable())
+    _s.InstantiateFunctionDefinition(M->getLocation(), M);
+  return !AccessorTranslator(M, cfg(), {}, nullptr).translate().empty();
+}
+
+void FunctionJob::writeInline(const Identifier &i, const std::string &params, Json::Value &j) {
+  const auto *method = cast<CXXMethodDecl>(_d);
+  FieldNames &fields = ClassDefineJob::fieldNames[method->getParent()];
+  std::string body = AccessorTranslator(method, cfg(), _paramNames, &fields).translate();
+  if (body.empty()) return;
+  std::string name = i.c + cfg().c_separator + cfg()._inline;
+  Identifier sig(_returnType, Identifier(name + params), cfg());
+  _out.hf() << "#ifndef __cplusplus\n";
+  _out.hf() << "// Inline accessor of " << _name << "\n";
+  _out.hf() << "static inline " << sig.c << " {\n";
+  _out.hf() << body;
+  _out.hf() << "}\n";
+  _out.hf() << "#endif // !__cplusplus\n\n";
+  j[jcfg()._inline] = name;
+}
+
+// Only types that are passed the same way to a C function and a member function can be used.
+static bool resolvable(QualType QT) {
+  return QT->isVoidType() || QT->isReferenceType() ||
+         (QT->isScalarType() && !QT->isMemberPointerType());
+}
+
+void FunctionJob::writeResolve(const Identifier &i, Json::Value &j) {
+  ASTContext &AC = _d->getASTContext();
+  const auto *method = cast<CXXMethodDecl>(_d);
+  const CXXRecordDecl *RD = method->getParent();
+  // The slot of a virtual function is only known for the Itanium C++ ABI
+  if (!AC.getTargetInfo().getCXXABI().isItaniumFamily()) return;
+  // Relative virtual tables hold 32-bit offsets instead of pointers to the functions
+  if (AC.getLangOpts().RelativeCXXABIVTables) return;
+  // The slot is called as a C function pointer, so the method's calling convention must be C's,
+  // unlike __thiscall on 32-bit MinGW.
+  CallingConv CC = method->getType()->castAs<FunctionType>()->getCallConv();
+  if (CC != AC.getDefaultCallingConvention(false, false)) return;
+  if (method->isVariadic() || !resolvable(method->getReturnType())) return;
+  for (const auto *P : method->parameters()) {
+    if (!resolvable(P->getType())) return;
+  }
+  // The method has a slot in the primary virtual table only if it's new, or overrides a method of
+  // a primary base.
+  std::unordered_set<const CXXRecordDecl *> primaries;
+  for (const CXXRecordDecl *B = RD; B; B = AC.getASTRecordLayout(B).getPrimaryBase())
+    primaries.emplace(B);
+  for (const auto *O : method->overridden_methods()) {
+    if (!primaries.count(O->getParent())) return;
+  }
+  auto *VT = dyn_cast<ItaniumVTableContext>(AC.getVTableContext());
+  if (!VT) return;
+  uint64_t index = VT->getMethodVTableIndex(GlobalDecl(method));
+
+  auto pointer = [&](QualType QT) {
+    return QT->isReferenceType() ? AC.getPointerType(QT.getNonReferenceType()) : QT;
+  };
+  QualType thisType = AC.getPointerType(AC.getRecordType(RD));
+  if (method->isConst()) thisType = AC.getPointerType(AC.getRecordType(RD).withConst());
+  std::vector<QualType> params = {thisType};
+  for (const auto *P : method->parameters()) params.push_back(pointer(P->getType()));
+  QualType fnType = AC.getPointerType(AC.getFunctionType(
+      pointer(method->getReturnType()), params, FunctionProtoType::ExtProtoInfo()));
+
+  std::string name = i.c;
+  name.insert(cfg()._root.size(), cfg()._resolve);
+  Identifier self(AC.getPointerType(AC.getRecordType(RD).withConst()), Identifier(cfg()._this),
+                  cfg());
+  Identifier sig(fnType, Identifier(name + "(" + self.c + ")"), cfg());
+  _out.hf() << "// Final overrider of " << _name << "\n";
+  exportFunction(name, sig.c);
+  _out.hf() << "\n";
+  _out.sf() << "// Final overrider of " << _name << "\n";
+  _out.sf() << sig.c << " {\n";
+  _out.sf() << "  auto vtable = *reinterpret_cast<void *const *const *>(" << cfg()._this << ");\n";
+  _out.sf() << "  return reinterpret_cast<" << Identifier(fnType, Identifier(), cfg()).c
+            << ">(vtable[" << index << "]);\n";
+  _out.sf() << "}\n\n";
+  j[jcfg()._resolve] = name;
+}
+
+void FunctionJob::writeBatch(const Identifier &i, const std::string &fname) {
+  const ASTContext &AC = _d->getASTContext();
+  const auto *method = dyn_cast<CXXMethodDecl>(_d);
+  std::string name = i.c + cfg().c_separator + cfg()._batch;
+  std::string idx = "[" + cfg()._index + "]";
+
+  std::stringstream proto;
+  proto << name << "(" << Identifier(AC.getSizeType(), Identifier(cfg()._count), cfg()).c;
+  std::stringstream result;
+  if (_returnParam) {
+    proto << ", " << Identifier(_returnParamType, Identifier(cfg()._return), cfg()).c;
+  } else if (!_returnType->isVoidType()) {
+    QualType RT = AC.getPointerType(_returnType);
+    proto << ", " << Identifier(RT, Identifier(cfg()._return), cfg()).c;
+    result << cfg()._return << idx << " = ";
+  }
+  std::stringstream callee;
+  if (method) {
+    QualType qp = AC.getRecordType(method->getParent());
+    if (method->isConst()) qp.addConst();
+    QualType thisType = AC.getPointerType(AC.getPointerType(qp).withConst());
+    proto << ", " << Identifier(thisType, Identifier(cfg()._this), cfg()).c;
+    callee << cfg()._this << idx << "->" << fname;
+  } else {
+    callee << i.cpp;
+  }
+  callee << "(";
+  for (size_t p = 0; p < _paramTypes.size(); p++) {
+    QualType PT = AC.getPointerType(_paramTypes[p].withConst());
+    proto << ", " << Identifier(PT, Identifier(_paramNames[p]), cfg()).c;
+    if (p) callee << ", ";
+    if (_paramDeref[p]) callee << "*";
+    callee << _paramNames[p] << idx;
+  }
+  callee << ")";
+  proto << ")";
+  if (_nothrow || _translate) proto << " " << cfg()._noexcept;
+  std::string signature = "void " + proto.str();
+
+  std::stringstream stmt;
+  if (_returnConstruct) {
+    Identifier rt(_returnParamType->getPointeeType(), Identifier(), cfg());
+    stmt << "new (" << cfg()._return << " + " << cfg()._index << ") " << rt.cpp << "("
+         << callee.str() << ");";
+  } else if (_returnParam) {
+    stmt << cfg()._return << idx << " = " << callee.str() << ";";
+  } else {
+    stmt << result.str() << callee.str() << ";";
+  }
+
+  _out.hf() << "// Batched " << _name << "\n";
+  exportFunction(name, signature);
+  _out.hf() << "\n";
+  _out.sf() << "// Batched " << _name << "\n";
+  _out.sf() << signature << " {\n";
+  std::stringstream loop;
+  loop << "for (" << Identifier(AC.getSizeType(), Identifier(cfg()._index), cfg()).cpp << " = 0; "
+       << cfg()._index << " < " << cfg()._count << "; " << cfg()._index << "++) {\n";
+  loop << "  " << stmt.str() << "\n";
+  loop << "}";
+  writeBody(loop.str(), false);
+  _out.sf() << "}\n\n";
+}
+
 void FunctionJob::impl() {
   bool extc = _d->isExternC() || _d->isInExternCContext();
-  _out.hf() << "// " << _location << "\n";
-  _out.hf() << "// " << _name << "\n";
+  writeComment(_location);
+  if (_returnConstruct) {
+    // Stubs used to assign the result to an object the caller had constructed
+    _out.hf() << "// The result is constructed in " << cfg()._return
+              << ", which must be uninitialized storage. Destroy it with " << cfg()._root
+              << cfg()._destroy << "*, not by constructing over it.\n";
+  }
   if (!extc) {
     _out.sf() << "// " << _location << "\n";
     _out.sf() << "// " << _name << "\n";
@@ -100,6 +613,8 @@ void FunctionJob::impl() {
   j[jcfg()._location] = _location;
   j[jcfg()._variadic] = _d->isVariadic();
   j[jcfg()._return] = jcfg().jsonType(_returnType);
+  j[jcfg()._noexcept] = _nothrow;
+  j[jcfg()._translated] = _translate;
 
   Json::Value args(Json::ValueType::arrayValue);
 
@@ -112,6 +627,29 @@ void FunctionJob::impl() {
     Json::Value arg(Json::ValueType::objectValue);
     arg[jcfg()._cname] = cfg()._return;
     arg[jcfg()._fieldType] = jcfg().jsonType(_returnParamType);
+    arg[jcfg()._uninitialized] = _returnConstruct;
+    args.append(arg);
+  }
+  if (!_returnSpan.isNull()) {
+    const ASTContext &AC = _d->getASTContext();
+    std::string lname = cfg()._return + cfg()._length;
+    QualType lt = AC.getSizeType();
+    if (_returnBuffer) {
+      proto << Identifier(_returnSpan, Identifier(cfg()._return), cfg()).c << ", ";
+
+      Json::Value arg(Json::ValueType::objectValue);
+      arg[jcfg()._cname] = cfg()._return;
+      arg[jcfg()._fieldType] = jcfg().jsonType(_returnSpan);
+      args.append(arg);
+    } else {
+      lt = AC.getPointerType(lt);
+    }
+    proto << Identifier(lt, Identifier(lname), cfg()).c;
+    firstP = false;
+
+    Json::Value arg(Json::ValueType::objectValue);
+    arg[jcfg()._cname] = lname;
+    arg[jcfg()._fieldType] = jcfg().jsonType(lt);
     args.append(arg);
   }
   if (method && !ctor) {
@@ -126,6 +664,7 @@ void FunctionJob::impl() {
     args.append(arg);
   }
   bool firstC = true;
+  _paramNames.resize(_d->getNumParams());
   for (size_t i = 0; i < _d->getNumParams(); i++) {
     const auto &p = _d->getParamDecl(i);
     if (!firstP) proto << ", ";
@@ -136,26 +675,43 @@ void FunctionJob::impl() {
     if (pname.empty()) pname = cfg()._root + "arg_" + std::to_string(i);
     Identifier pn(pname, cfg());
     Identifier pi(pt, pn, cfg());
+    _paramNames[i] = pn.c;
     proto << pi.c;
-    call << pn.c;
     firstC = firstP = false;
 
     Json::Value arg(Json::ValueType::objectValue);
     arg[jcfg()._cname] = pn.c;
     arg[jcfg()._fieldType] = jcfg().jsonType(pt);
     args.append(arg);
+
+    if (_paramSpan[i].isNull()) {
+      call << pn.c;
+    } else {
+      std::string lname = pn.c + cfg()._length;
+      QualType lt = _d->getASTContext().getSizeType();
+      proto << ", " << Identifier(lt, Identifier(lname), cfg()).c;
+      call << Identifier(_paramSpan[i], Identifier(), cfg()).cpp << "(" << pn.c << ", " << lname
+           << ")";
+
+      Json::Value arg(Json::ValueType::objectValue);
+      arg[jcfg()._cname] = lname;
+      arg[jcfg()._fieldType] = jcfg().jsonType(lt);
+      args.append(arg);
+    }
   }
   j[jcfg()._args] = args;
   if (_d->isVariadic()) {
     proto << ", ...";
   }
   proto << ")";
+  if (_nothrow || _translate) proto << " " << cfg()._noexcept;
   Identifier signature(_returnType, Identifier(proto.str()), cfg());
-  _out.hf() << signature.c << ";\n";
   if (extc) {
+    _out.hf() << signature.c << ";\n";
     _out.hf() << "#endif // !__cplusplus\n\n";
     _out.sf() << "// defined externally\n\n";
   } else {
+    exportFunction(i.c, signature.c);
     _out.hf() << "\n";
     std::string fname;
     if (auto *CD = dyn_cast<CXXConversionDecl>(_d)) {
@@ -163,33 +719,61 @@ void FunctionJob::impl() {
     } else {
       fname = getName(_d);
     }
-    _out.sf() << signature.c << " {\n  ";
-    if (dtor) {
-      _out.sf() << "delete " << cfg()._this;
-    } else {
-      if (_returnParam) {
-        _out.sf() << "*" << cfg()._return << " = ";
-        if (method)
-          _out.sf() << cfg()._this << "->" << fname;
-        else
-          _out.sf() << i.cpp;
-      } else if (ctor)
-        _out.sf() << "return new " << Identifier(method->getParent(), cfg()).cpp;
-      else {
-        _out.sf() << "return ";
-        if (method)
-          _out.sf() << cfg()._this << "->" << fname;
-        else
-          _out.sf() << i.cpp;
-      }
-      _out.sf() << "(";
-      _out.sf() << call.str();
-      _out.sf() << ")";
+    // A final method has no other overrider, so it can be called without going through the
+    // virtual table. The _direct variant does the same for the overrider a caller already knows.
+    std::string qualified = method ? Identifier(method->getParent(), cfg()).cpp + "::" : "";
+    bool final = method && method->isVirtual() &&
+                 (method->hasAttr<FinalAttr>() || method->getParent()->hasAttr<FinalAttr>());
+    std::string callee = method ? cfg()._this + "->" + (final ? qualified : "") + fname : i.cpp;
+    // A stub identical to an earlier one is only an alias of it, where the object format allows
+    std::string key = aliasKey();
+    bool alias = key.size() && stubs.count(key);
+    if (alias) {
+      _out.sf() << "#if defined(__ELF__)\n";
+      _out.sf() << signature.c << " __attribute__((alias(\"" << stubs.at(key) << "\")));\n";
+      _out.sf() << "#else\n";
+      j[jcfg()._aliasOf] = stubs.at(key);
+    }
+    _out.sf() << signature.c << " {\n";
+    writeBody(statement(callee, call.str()), !_returnType->isVoidType());
+    _out.sf() << "}\n";
+    if (alias) _out.sf() << "#endif\n";
+    _out.sf() << "\n";
+
+    if (method && method->isVirtual() && !dtor) {
+      j[jcfg()._virtual] = true;
+      j[jcfg()._final] = final;
+    }
+    if (method && method->isVirtual() && !dtor && !final && !method->isPure()) {
+      std::string direct = i.c + cfg().c_separator + cfg()._direct;
+      std::string params = proto.str().substr(i.c.size());
+      Identifier dsig(_returnType, Identifier(direct + params), cfg());
+      _out.hf() << "// Non-virtual call of " << _name << "\n";
+      exportFunction(direct, dsig.c);
+      _out.hf() << "\n";
+      _out.sf() << "// Non-virtual call of " << _name << "\n";
+      _out.sf() << dsig.c << " {\n";
+      writeBody(statement(cfg()._this + "->" + qualified + fname, call.str()),
+                !_returnType->isVoidType());
+      _out.sf() << "}\n\n";
+      j[jcfg()._direct] = direct;
     }
-    _out.sf() << ";\n}\n\n";
+    if (method && method->isVirtual() && !dtor) writeResolve(i, j);
+    if (_inline) writeInline(i, proto.str().substr(i.c.size()), j);
+
+    if (_batch) {
+      writeBatch(i, fname);
+      j[jcfg()._batch] = i.c + cfg().c_separator + cfg()._batch;
+    }
+
+    std::string inst = instantiation(fname);
+    if (!inst.empty()) _out.addInstantiation(inst);
+    if (Bench) addBenchmark(i, fname);
+    // Only a stub that was written completely can be aliased by later ones
+    if (!alias && key.size()) stubs[key] = i.c;
   }
 
   j["mangled"] = nameGen().getName(_d);
 
-  _out.json()[jcfg()._function][_name] = j;
+  _out.jsonEntry(jcfg()._function, _name) = j;
 }
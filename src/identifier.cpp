@@ -10,7 +10,9 @@
 #include <clang/AST/DeclTemplate.h>
 #include <clang/AST/TemplateBase.h>
 #include <clang/Basic/SourceManager.h>
+#include <clang/Index/USRGeneration.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <unordered_map>
@@ -141,6 +143,34 @@ void IdentifierConfig::printCTemplateArgs(std::ostream &os,
   }
 }
 
+void IdentifierConfig::printCTemplateArgs(std::ostream &os, const TemplateDecl *TD,
+                                          const ArrayRef<clang::TemplateArgument> &Args) const {
+  ArrayRef<TemplateArgument> args = Args;
+  if (_elideDefaultArgs && TD) {
+    // like std::allocator, trailing arguments that are the defaults can be left out
+    const TemplateParameterList *TPL = TD->getTemplateParameters();
+    while (args.size() && args.size() <= TPL->size()) {
+      const NamedDecl *param = TPL->getParam(args.size() - 1);
+      if (param->isTemplateParameterPack() ||
+          !isSubstitutedDefaultArgument(TD->getASTContext(), args.back(), param, Args,
+                                        TPL->getDepth()))
+        break;
+      args = args.drop_back();
+    }
+  }
+
+  std::stringstream ss;
+  printCTemplateArgs(ss, args);
+  std::string name = ss.str();
+  if (_maxTemplateLength && name.size() > _maxTemplateLength) {
+    std::stringstream hash;
+    hash << "h" << std::hex << stableHash(name);
+    _shortNames[name] = hash.str();
+    name = hash.str();
+  }
+  os << name;
+}
+
 // closely follows the NamedDecl::printQualifiedName method
 std::string IdentifierConfig::getCName(const clang::NamedDecl *d, bool root) const {
   if (Identifier::ids.count(d)) {
@@ -185,7 +215,7 @@ std::string IdentifierConfig::getCName(const clang::NamedDecl *d, bool root) con
       os << Spec->getName().str();
       const TemplateArgumentList &TemplateArgs = Spec->getTemplateArgs();
       os << c_separator;
-      printCTemplateArgs(os, TemplateArgs.asArray());
+      printCTemplateArgs(os, Spec->getSpecializedTemplate(), TemplateArgs.asArray());
     } else if (const auto *ND = dyn_cast<NamespaceDecl>(DC)) {
       if (ND->isAnonymousNamespace()) {
         throw mangling_error("Anonymous namespace", d, *this);
@@ -228,13 +258,17 @@ std::string IdentifierConfig::getCName(const clang::NamedDecl *d, bool root) con
     }
 
     const TemplateArgumentList *l = nullptr;
-    if (const auto *t = dyn_cast<ClassTemplateSpecializationDecl>(d))
+    const TemplateDecl *TD = nullptr;
+    if (const auto *t = dyn_cast<ClassTemplateSpecializationDecl>(d)) {
       l = &t->getTemplateArgs();
-    else if (const auto *t = dyn_cast<FunctionDecl>(d))
+      TD = t->getSpecializedTemplate();
+    } else if (const auto *t = dyn_cast<FunctionDecl>(d)) {
       l = t->getTemplateSpecializationArgs();
+      TD = t->getPrimaryTemplate();
+    }
     if (l != nullptr) {
       os << c_separator;
-      printCTemplateArgs(os, l->asArray());
+      printCTemplateArgs(os, TD, l->asArray());
     }
   }
 
@@ -299,6 +333,20 @@ std::string IdentifierConfig::getCName(const QualType &qt, std::string name, boo
 std::unordered_map<const clang::NamedDecl *, Identifier> Identifier::ids;
 std::unordered_map<std::string, const clang::NamedDecl *> Identifier::dups;
 
+// Get the unified symbol resolution of the declaration, which is the same across runs
+std::string IdentifierConfig::getUSR(const Decl *D) const {
+  SmallString<128> buf;
+  if (index::generateUSRForDecl(D, buf)) return "";
+  return buf.str().str();
+}
+
+// Whether the name is the base name, or the base name with a numeric suffix for duplicates
+static bool isSuffixed(const std::string &name, const std::string &base) {
+  if (name == base) return true;
+  if (name.size() <= base.size() + 1 || name.compare(0, base.size() + 1, base + "_")) return false;
+  return std::all_of(name.begin() + base.size() + 1, name.end(), ::isdigit);
+}
+
 Identifier::Identifier(const clang::NamedDecl *d, const IdentifierConfig &cfg) {
   if (d == nullptr) {
     throw mangling_error("Null Decl", d, cfg);
@@ -333,14 +381,26 @@ Identifier::Identifier(const clang::NamedDecl *d, const IdentifierConfig &cfg) {
     if (dups.count(c)) {
       throw mangling_error("Generated symbol conflicts with a C symbol", dups.at(c), cfg);
     }
+  } else if (!cfg._imported.empty() && cfg._imported.count(cfg.getUSR(d))) {
+    // An imported library already declares it, with the name it was given there
+    c = cfg._imported.at(cfg.getUSR(d));
   } else {
     c = cfg.getCName(d);
-    if (dups.count(c)) {
+    // A name from an earlier run is kept, and the names of other declarations aren't taken
+    std::string usr = cfg._stableNames ? cfg.getUSR(d) : "";
+    auto pin = usr.empty() ? cfg._pinned.end() : cfg._pinned.find(usr);
+    if (pin != cfg._pinned.end() && isSuffixed(pin->second, c) && !dups.count(pin->second)) {
+      c = pin->second;
+    } else if (dups.count(c) || cfg._reserved.count(c)) {
       unsigned cnt = 2;
       std::string nc;
-      while (dups.count(nc = c + "_" + std::to_string(cnt))) cnt++;
+      while (dups.count(nc = c + "_" + std::to_string(cnt)) || cfg._reserved.count(nc)) cnt++;
       c = nc;
     }
+    if (!usr.empty()) {
+      cfg._pinned[usr] = c;
+      cfg._reserved.emplace(c);
+    }
   }
 
   cpp = cfg.getCXXQualifiedName(d);
@@ -441,3 +501,12 @@ const TypedefDecl *unplusplus::getAnonTypedef(const NamedDecl *d) {
   }
   return nullptr;
 }
+
+uint64_t unplusplus::stableHash(const std::string &s) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : s) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
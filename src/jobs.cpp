@@ -6,6 +6,13 @@
 #include "jobs.hpp"
 
 #include <clang/AST/DeclFriend.h>
+#include <clang/Lex/LiteralSupport.h>
+#include <llvm/Support/Path.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
 
 #include "cxxrecord.hpp"
 #include "enum.hpp"
@@ -22,6 +29,17 @@ JobBase::JobBase(JobManager &manager, clang::Sema &S)
 }
 
 IdentifierConfig &JobBase::cfg() { return _manager.cfg(); }
+
+std::string JobBase::partitionOf(const Decl *D) {
+  return _manager.partitionOf(D->getLocation(), D->getASTContext().getSourceManager(),
+                              D->getDeclContext());
+}
+
+void JobBase::writeComment(const std::string &location) {
+  if (CompactHeader) return;
+  _out.hf() << "// " << location << "\n";
+  _out.hf() << "// " << _name << "\n";
+}
 JsonConfig &JobBase::jcfg() { return _manager.jcfg(); }
 ASTNameGenerator &JobBase::nameGen() { return _manager.nameGen(); }
 
@@ -93,21 +111,37 @@ void JobBase::depends(clang::QualType QT, bool define) {
   }
 }
 
+void JobBase::exportFunction(const std::string &name, const std::string &signature) {
+  _out.hf() << _out.exportMacro() << " " << signature << ";\n";
+  manager().addApi(name, signature);
+}
+
 void JobBase::checkReady() {
   if (Verbose) std::cout << "Job Created: " << _name << std::endl;
   if (_depends.empty()) _manager._ready.push(this);
 }
 
 void JobBase::run() {
-  if (_done) {
+  if (_done || _failed) {
     return;
   }
   if (Verbose) std::cout << "Job Started: " << _name << std::endl;
+  size_t api = _manager._api.size();
   try {
+    _out.setPartition(_partition);
+    // The mark includes the partition, so what the job writes to it can be discarded too
+    _out.mark();
     impl();
+    _out.setPartition("");
   } catch (const mangling_error &err) {
     std::cerr << "Job Failed: " << _name << " from " << err.what() << std::endl;
-    std::exit(1);
+    if (!Quarantine) std::exit(1);
+    // Discard what the job wrote, so the outputs are still valid
+    _out.setPartition("");
+    _out.rollback();
+    _manager._api.resize(api);
+    fail(err.what());
+    return;
   }
   _done = true;
   if (Verbose) std::cout << "Job Done: " << _name << std::endl;
@@ -117,6 +151,16 @@ void JobBase::run() {
   _dependent.clear();
 }
 
+void JobBase::fail(const std::string &reason) {
+  if (_failed) return;
+  _failed = true;
+  if (decl()) manager().filter().quarantine(decl(), reason);
+  for (auto *d : _dependent) {
+    d->fail("depends on " + _name);
+  }
+  _dependent.clear();
+}
+
 void JobBase::satisfy(JobBase *dependency) {
   _depends.remove(dependency);
   if (_depends.empty()) {
@@ -166,8 +210,7 @@ TypedefJob::TypedefJob(TypedefJob::type *D, Sema &S, JobManager &manage)
 
 void TypedefJob::impl() {
   if (_anonymousStruct) return;
-  _out.hf() << "// " << _location << "\n";
-  _out.hf() << "// " << _name << "\n";
+  writeComment(_location);
   Identifier i(_d, cfg());
   _out.hf() << "#ifdef __cplusplus\n";
   if (_replacesFiltered) {
@@ -184,27 +227,309 @@ void TypedefJob::impl() {
 }
 
 VarJob::VarJob(VarJob::type *D, Sema &S, JobManager &jm) : Job<VarJob::type>(D, S, jm) {
+  _partition = partitionOf(_d);
   if (auto *VTD = _d->getDescribedVarTemplate()) manager().lazyCreate(VTD, S);
   if (auto *VTSD = dyn_cast<VarTemplateSpecializationDecl>(_d))
     manager().lazyCreate(VTSD->getTemplateInstantiationArgs().asArray(), S);
 
-  _ptr = _d->getASTContext().getPointerType(_d->getType());
-  _ptr.addConst();
-  depends(_ptr, false);
+  evaluate();
+  if (_value.empty()) {
+    _ptr = _d->getASTContext().getPointerType(_d->getType());
+    _ptr.addConst();
+    depends(_ptr, false);
+  } else {
+    depends(_d->getType(), true);
+  }
   checkReady();
 }
 
+void VarJob::evaluate() {
+  const ASTContext &AC = _d->getASTContext();
+  QualType T = _d->getType().getCanonicalType();
+  // a volatile variable has to be read each time, so it keeps its pointer
+  if (!T.isConstQualified() || T.isVolatileQualified()) return;
+  if (!T->isIntegralOrEnumerationType() && !T->isRealFloatingType()) return;
+  if (const auto *ET = T->getAs<EnumType>()) {
+    if (getName(ET->getDecl()).empty() && !getAnonTypedef(ET->getDecl())) return;
+  }
+  const Expr *init = _d->getInit();
+  if (!init || init->isValueDependent()) return;
+  // Only values that C++ can check at compile time are copied, so changes to them are caught
+  if (!_d->isUsableInConstantExpressions(AC)) return;
+  const APValue *V = _d->evaluateValue();
+  if (!V) return;
+
+  std::string value;
+  if (V->isInt()) {
+    const llvm::APSInt &I = V->getInt();
+    if (I.getBitWidth() > 64) return;
+    static const std::unordered_map<BuiltinType::Kind, std::string> suffixes = {
+        {BuiltinType::UInt, "u"},
+        {BuiltinType::Long, "l"},
+        {BuiltinType::ULong, "ul"},
+        {BuiltinType::LongLong, "ll"},
+        {BuiltinType::ULongLong, "ull"}};
+    std::string suffix;
+    if (const auto *BT = T->getAs<BuiltinType>()) {
+      if (suffixes.count(BT->getKind())) suffix = suffixes.at(BT->getKind());
+    }
+    SmallString<24> s;
+    if (I.isSigned() && I.isMinSignedValue() && I.getBitWidth() > 1) {
+      // the negation of the positive literal would overflow
+      llvm::APSInt next(I);
+      (++next).toString(s, 10);
+      value = "(" + std::string(s.c_str()) + suffix + " - 1)";
+    } else {
+      I.toString(s, 10);
+      value = s.c_str() + suffix;
+    }
+  } else if (V->isFloat()) {
+    const llvm::APFloat &F = V->getFloat();
+    if (!F.isFinite()) return;
+    SmallString<32> s;
+    F.toString(s);
+    value = s.c_str();
+    if (value.find_first_of(".eE") == std::string::npos) value += ".0";
+    if (T->isSpecificBuiltinType(BuiltinType::Float))
+      value += "f";
+    else if (T->isSpecificBuiltinType(BuiltinType::LongDouble))
+      value += "L";
+  } else {
+    return;
+  }
+  _value = "((" + Identifier(T.getUnqualifiedType(), Identifier(), cfg()).c + ")" + value + ")";
+}
+
 void VarJob::impl() {
   Identifier i(_d, cfg());
+  writeComment(_location);
+  if (_value.size()) {
+    // Constants are copied, so C can use them in constant expressions without loading them
+    _out.hf() << "#define " << i.c << " " << _value << "\n";
+    _out.hf() << "#ifdef __cplusplus\n";
+    _out.hf() << "static_assert(" << i.c << " == " << i.cpp
+              << ", \"Value of C constant must match C++\");\n";
+    _out.hf() << "#endif // __cplusplus\n";
+    _out.hf() << "\n";
+    return;
+  }
   Identifier vi(_ptr, i, cfg());
-  _out.hf() << "// " << _location << "\n";
-  _out.hf() << "// " << _name << "\n";
-  _out.hf() << "extern " << vi.c << ";\n\n";
+  _out.hf() << _out.exportMacro() << " extern " << vi.c << ";\n\n";
+  _out.addExport(i.c);
   _out.sf() << "// " << _location << "\n";
   _out.sf() << "// " << _name << "\n";
   _out.sf() << vi.c << " = &(" << i.cpp << ");\n\n";
 }
 
+JobManager::JobManager(Outputs &out, clang::ASTContext &ASTC, DeclFilterConfig &FC)
+    : _out(out),
+      _filter(ASTC.getLangOpts(), FC),
+      _cfg(ASTC.getLangOpts(), _filter),
+      _jcfg(_cfg, ASTC, out),
+      _ng(ASTC) {
+  _cfg._elideDefaultArgs = ElideDefaultTemplateArgs;
+  _cfg._maxTemplateLength = MaxTemplateNameLength;
+  if (!NamesFile.empty()) readNames();
+  for (const auto &path : Imports) readImport(path);
+  if (TranslateExceptions) writeErrorRuntime();
+}
+
+void JobManager::readNames() {
+  _cfg._stableNames = true;
+  std::ifstream ifs(NamesFile.getValue());
+  // There are no names to keep on the first run
+  if (!ifs) return;
+  Json::Value names;
+  Json::CharReaderBuilder rbuilder;
+  std::string errs;
+  if (!Json::parseFromStream(rbuilder, ifs, &names, &errs) || !names.isObject()) {
+    std::cerr << "Error: failed to read " << NamesFile.getValue() << ": " << errs << std::endl;
+    std::exit(1);
+  }
+  for (const auto &usr : names.getMemberNames()) {
+    _cfg._pinned[usr] = names[usr].asString();
+    _cfg._reserved.emplace(names[usr].asString());
+  }
+}
+
+void JobManager::writeNames() {
+  Json::Value names(Json::ValueType::objectValue);
+  for (const auto &n : _cfg._pinned) names[n.first] = n.second;
+  Json::StreamWriterBuilder wbuilder;
+  wbuilder["indentation"] = " ";
+  std::unique_ptr<Json::StreamWriter> writer{wbuilder.newStreamWriter()};
+  std::ofstream ofs(NamesFile.getValue());
+  writer->write(names, &ofs);
+  ofs << std::endl;
+}
+
+void JobManager::readImport(const std::string &path) {
+  std::ifstream ifs(path);
+  Json::Value lib;
+  Json::CharReaderBuilder rbuilder;
+  std::string errs;
+  if (!ifs || !Json::parseFromStream(rbuilder, ifs, &lib, &errs) || !lib.isObject() ||
+      !lib[_jcfg._header].isString()) {
+    std::cerr << "Error: failed to import " << path << ": " << errs << std::endl;
+    std::exit(1);
+  }
+  _out.addImport(lib[_jcfg._header].asString());
+  const Json::Value &decls = lib[_jcfg._declarations];
+  for (const auto &usr : decls.getMemberNames()) {
+    std::string c = decls[usr][_jcfg._cname].asString();
+    _cfg._imported[usr] = c;
+    // new declarations can't take the name either, since both headers are included
+    _cfg._reserved.emplace(c);
+    if (decls[usr][_jcfg._defined].asBool()) _importedDefinitions.emplace(usr);
+  }
+}
+
+void JobManager::writeDeclarations() {
+  Json::Value decls(Json::ValueType::objectValue);
+  // What this library imported is declared by its header too
+  for (const auto &i : _cfg._imported) {
+    decls[i.first][_jcfg._cname] = i.second;
+    decls[i.first][_jcfg._defined] = _importedDefinitions.count(i.first) > 0;
+  }
+  for (auto &j : _jobs) {
+    auto *ND = dyn_cast_or_null<NamedDecl>(j->decl());
+    if (!ND || !j->isDone()) continue;
+    std::string usr = _cfg.getUSR(ND);
+    if (usr.empty()) continue;
+    // A class may only be forward declared, by a job separate from the one that defines it
+    bool defines = !isa<TagDecl>(ND) || (_definitions.count(ND) && _definitions.at(ND) == j.get());
+    Json::Value &d = decls[usr];
+    d[_jcfg._cname] = Identifier(ND, cfg()).c;
+    d[_jcfg._defined] = d[_jcfg._defined].asBool() || defines;
+  }
+  _out.json()[_jcfg._declarations] = decls;
+}
+
+void JobManager::writeErrorRuntime() {
+  std::string prefix = _cfg._root + _out.libName() + _cfg.c_separator;
+  _out.setPartition("error");
+  _out.hf() << "// Exceptions thrown through stubs are stored in a thread-local error\n";
+  _out.hf() << "enum {\n";
+  _out.hf() << "  " << prefix << "no_error = 0,\n";
+  _out.hf() << "  " << prefix << "bad_alloc = 1,\n";
+  _out.hf() << "  " << prefix << "exception = 2,\n";
+  _out.hf() << "  " << prefix << "unknown_exception = 3,\n";
+  _out.hf() << "};\n";
+  std::vector<std::string> decls = {
+      "int " + prefix + "error(void) " + _cfg._noexcept,
+      "const char *" + prefix + "error_message(void) " + _cfg._noexcept,
+      "void " + prefix + "clear_error(void) " + _cfg._noexcept};
+  for (auto &d : decls) _out.hf() << _out.exportMacro() << " " << d << ";\n";
+  _out.hf() << "\n";
+  _out.setPartition("");
+  addApi(prefix + "error", decls[0]);
+  addApi(prefix + "error_message", decls[1]);
+  addApi(prefix + "clear_error", decls[2]);
+
+  _out.sf() << "// Exception translation\n";
+  _out.sf() << "#include <string>\n";
+  _out.sf() << "static thread_local int " << prefix << "error_code = 0;\n";
+  _out.sf() << "static thread_local std::string " << prefix << "error_text;\n";
+  _out.sf() << "static void " << prefix << "set_error(int code, const char *message) noexcept {\n";
+  _out.sf() << "  " << prefix << "error_code = code;\n";
+  _out.sf() << "  try {\n";
+  _out.sf() << "    " << prefix << "error_text = message;\n";
+  _out.sf() << "  } catch (...) {\n";
+  _out.sf() << "    " << prefix << "error_text.clear();\n";
+  _out.sf() << "  }\n}\n";
+  _out.sf() << "int " << prefix << "error(void) noexcept { return " << prefix << "error_code; }\n";
+  _out.sf() << "const char *" << prefix << "error_message(void) noexcept {\n";
+  _out.sf() << "  return " << prefix << "error_text.c_str();\n}\n";
+  _out.sf() << "void " << prefix << "clear_error(void) noexcept {\n";
+  _out.sf() << "  " << prefix << "error_code = 0;\n";
+  _out.sf() << "  " << prefix << "error_text.clear();\n}\n\n";
+}
+
+void JobManager::addApi(const std::string &name, const std::string &signature) {
+  // turn the declarator of the function into a pointer to it
+  std::string member = signature;
+  size_t pos = member.find(name + "(");
+  if (pos == std::string::npos) return;
+  member.replace(pos, name.size(), "(*" + name + ")");
+  _api.emplace_back(name, member);
+  _out.addExport(name);
+}
+
+void JobManager::finish() {
+  writeApi();
+  if (_cfg._stableNames) writeNames();
+  writeDeclarations();
+  for (const auto &n : _cfg._shortNames) _out.json()[_jcfg._shortNames][n.first] = n.second;
+  for (const auto &q : _filter.quarantined()) {
+    Json::Value j(Json::ValueType::objectValue);
+    j[_jcfg._qname] = q.first;
+    j[_jcfg._reason] = q.second;
+    _out.json()[_jcfg._quarantine].append(j);
+    _out.addExclusion(q.first);
+  }
+}
+
+void JobManager::writeApi() {
+  if (_api.empty()) return;
+  std::string name = _cfg._root + _out.libName() + _cfg.c_separator + _cfg._api;
+  std::string type = "struct " + name + _cfg._struct;
+  std::string macro = name + _cfg.c_separator + "version";
+  std::transform(macro.begin(), macro.end(), macro.begin(), ::toupper);
+
+  // The version changes whenever a function is added, removed, reordered or changes signature
+  std::string all;
+  for (auto &a : _api) all += a.second + ";";
+  std::stringstream version;
+  version << "0x" << std::hex << stableHash(all) << "ULL";
+
+  // The table is only needed by code that loads the library dynamically
+  _out.setPartition(_cfg._api);
+  _out.hf() << "// Table of all the functions, to load the whole API with a single symbol\n";
+  _out.hf() << "#define " << macro << " " << version.str() << "\n";
+  _out.hf() << type << " {\n";
+  _out.hf() << "  unsigned long long version;\n";
+  _out.hf() << "  unsigned long long count;\n";
+  for (auto &a : _api) _out.hf() << "  " << a.second << ";\n";
+  _out.hf() << "};\n";
+  _out.hf() << _out.exportMacro() << " const " << type << " *" << name << "(void) "
+            << _cfg._noexcept << ";\n\n";
+  _out.setPartition("");
+  _out.addExport(name);
+
+  _out.sf() << "// Table of all the functions\n";
+  _out.sf() << "const " << type << " *" << name << "(void) noexcept {\n";
+  _out.sf() << "  static const " << type << " api = {\n";
+  _out.sf() << "      " << macro << ",\n";
+  _out.sf() << "      " << _api.size() << ",\n";
+  for (auto &a : _api) _out.sf() << "      &" << a.first << ",\n";
+  _out.sf() << "  };\n";
+  _out.sf() << "  return &api;\n}\n\n";
+
+  Json::Value j(Json::ValueType::arrayValue);
+  for (auto &a : _api) j.append(a.first);
+  _out.json()[_jcfg._api] = j;
+  _out.json()[_jcfg._apiVersion] = version.str();
+}
+
+std::string JobManager::partitionOf(SourceLocation Loc, const SourceManager &SM,
+                                    const DeclContext *DC) {
+  if (SplitHeaders == SplitSource) {
+    StringRef file = SM.getFilename(SM.getExpansionLoc(Loc));
+    return file.empty() ? "builtin" : _cfg.sanitize(llvm::sys::path::filename(file).str());
+  }
+  if (SplitHeaders == SplitNamespace) {
+    // Inline and anonymous namespaces are part of the namespace that contains them
+    std::string ns;
+    for (; DC; DC = DC->getParent()) {
+      const auto *ND = dyn_cast<NamespaceDecl>(DC);
+      if (!ND || ND->isInline() || ND->isAnonymousNamespace()) continue;
+      ns = ns.empty() ? ND->getName().str() : ND->getName().str() + "_" + ns;
+    }
+    return ns.empty() ? "global" : _cfg.sanitize(ns);
+  }
+  return "";
+}
+
 void JobManager::flush(Sema &S) {
   while (_lazy.size()) {
     create(_lazy.front(), S);
@@ -219,7 +544,7 @@ void JobManager::flush(Sema &S) {
 JobManager::~JobManager() {
   int incomplete = 0;
   for (auto &j : _jobs) {
-    if (!j->isDone()) {
+    if (!j->isDone() && !j->isFailed()) {
       std::cerr << "Incomplete job: " << j->name() << std::endl;
       for (auto *d : j->dependencies()) {
         std::cerr << "  -> Needs: " << d->name() << std::endl;
@@ -306,6 +631,15 @@ void JobManager::create(Decl *D, clang::Sema &S) {
   }
 
   if (_filter.filterOut(D)) return;
+
+  // Test if a library that was generated earlier already wraps it
+  if (importDecl(D)) {
+    // The imported header may only forward declare the class, so it's defined here
+    auto *RD = dyn_cast<CXXRecordDecl>(D);
+    if (RD && ClassDefineJob::accept(RD, cfg(), S) && !isDefined(RD))
+      new ClassDefineJob(RD, S, *this);
+    return;
+  }
   if (D->isTemplated()) create(D->getDescribedTemplate(), S);
 
   if (auto *SD = dyn_cast<TypedefDecl>(D)) {
@@ -329,6 +663,7 @@ void JobManager::create(Decl *D, clang::Sema &S) {
     if (auto *CTD = dyn_cast<ClassTemplateDecl>(SD)) {
       if (CTD->getTemplatedDecl()->isCompleteDefinition()) {
         for (auto *Special : CTD->specializations()) {
+          importDecl(Special);
           if (!isDefined(Special)) {
             Special->setSpecializedTemplate(CTD);
             if (ClassDefineJob::accept(Special, cfg(), S) && !isDefined(Special))
@@ -437,6 +772,16 @@ bool JobManager::isDefined(clang::Decl *D) {
   return false;
 }
 
+bool JobManager::importDecl(clang::Decl *D) {
+  if (_cfg._imported.empty()) return false;
+  std::string usr = _cfg.getUSR(D);
+  if (!_cfg._imported.count(usr)) return false;
+  // Create dummies for jobs needing it to depend on, like for C headers
+  if (!_declarations.count(D)) declare(D, nullptr);
+  if (_importedDefinitions.count(usr) && !_definitions.count(D)) define(D, nullptr);
+  return true;
+}
+
 bool JobManager::prevDeclared(clang::Decl *D) {
   Decl *P = D->getPreviousDecl();
   while (P) {
@@ -462,10 +807,41 @@ bool JobManager::renameFiltered(NamedDecl *D, NamedDecl *New) {
   return false;
 }
 
+// Get the spelling of a literal, if the tokens are one, optionally negated and parenthesized.
+static bool macroLiteral(const Preprocessor &PP, const MacroInfo *MI, std::string &spelling,
+                         bool &numeric) {
+  std::vector<Token> toks(MI->tokens_begin(), MI->tokens_end());
+  if (toks.size() >= 3 && toks.front().is(tok::l_paren) && toks.back().is(tok::r_paren))
+    toks = std::vector<Token>(toks.begin() + 1, toks.end() - 1);
+  bool negative = toks.size() == 2 && toks[0].is(tok::minus);
+  if (toks.size() != (negative ? 2 : 1)) return false;
+  const Token &lit = toks.back();
+  std::string text = PP.getSpelling(lit);
+  numeric = lit.is(tok::numeric_constant);
+  if (numeric) {
+    // digit separators and user-defined suffixes aren't C
+    if (text.find('\'') != std::string::npos) return false;
+    NumericLiteralParser parser(text, lit.getLocation(), PP.getSourceManager(), PP.getLangOpts(),
+                                PP.getTargetInfo(), PP.getDiagnostics());
+    if (parser.hadError || parser.hasUDSuffix() || parser.isImaginary ||
+        parser.isFixedPointLiteral())
+      return false;
+  } else if (!lit.is(tok::string_literal) || negative) {
+    return false;
+  }
+  spelling = (negative ? "-" : "") + text;
+  if (negative || toks.size() != MI->getNumTokens()) spelling = "(" + spelling + ")";
+  return true;
+}
+
 void JobManager::visitMacros(const Preprocessor &PP) {
+  const SourceManager &SM = PP.getSourceManager();
+  // sorted, so the output doesn't depend on the order of the hash table
+  std::map<std::string, const MacroInfo *> macros;
   for (const auto &m : PP.macros()) {
     const clang::MacroInfo *mi = m.getSecond().getLatest()->getMacroInfo();
     std::string name(m.getFirst()->getName());
+    if (!mi) continue;
 
     if (Identifier::dups.count(name)) {
       std::cerr << "Warning: The macro " << name << " at "
@@ -473,7 +849,51 @@ void JobManager::visitMacros(const Preprocessor &PP) {
                 << " shadows an existing declaration "
                 << cfg().getDebugName(Identifier::dups.at(name)) << std::endl;
     }
+    macros[name] = mi;
+  }
+
+  for (const auto &m : macros) {
+    const std::string &name = m.first;
+    const MacroInfo *mi = m.second;
+    SourceLocation loc = mi->getDefinitionLoc();
+    // names that are reserved belong to the implementation
+    if (name[0] == '_' && (name.size() == 1 || name[1] == '_' || std::isupper(name[1]))) continue;
+    if (mi->isFunctionLike() || mi->isBuiltinMacro() || loc.isInvalid()) continue;
+    if (SM.isWrittenInBuiltinFile(loc) || SM.isWrittenInCommandLineFile(loc)) continue;
+    // C code would get these from the C headers themselves, and the standard and third-party
+    // headers have macros of their own that aren't part of the wrapped library
+    if (_filter.isCHeader(loc, SM) || !_filter.isWrappedHeader(loc, SM)) continue;
+
+    std::string value;
+    bool numeric;
+    if (!macroLiteral(PP, mi, value, numeric)) continue;
+
+    std::string cname = _cfg._root + _cfg.sanitize(name);
+    if (Identifier::dups.count(cname)) {
+      std::cerr << "Warning: The macro " << name << " isn't copied, because " << cname
+                << " is already the name of " << cfg().getDebugName(Identifier::dups.at(cname))
+                << std::endl;
+      continue;
+    }
+    std::string location = loc.printToString(SM);
+    _out.setPartition(partitionOf(loc, SM));
+    if (!CompactHeader) _out.hf() << "// " << location << "\n";
+    _out.hf() << "#define " << cname << " " << value << "\n";
+    if (numeric) {
+      _out.hf() << "#ifdef __cplusplus\n";
+      _out.hf() << "static_assert(" << cname << " == " << name
+                << ", \"Value of C macro must match C++\");\n";
+      _out.hf() << "#endif // __cplusplus\n";
+    }
+    _out.hf() << "\n";
+
+    Json::Value j(Json::ValueType::objectValue);
+    j[_jcfg._cname] = cname;
+    j[_jcfg._location] = location;
+    j[_jcfg._value] = value;
+    _out.jsonEntry(_jcfg._macro, name) = j;
   }
+  _out.setPartition("");
 }
 
 void JobManager::finishTemplates(clang::Sema &S) {
@@ -18,6 +18,7 @@ JsonConfig::JsonConfig(const IdentifierConfig &IC, const ASTContext &AC, Outputs
   Json::Value &root = Out.json();
   root[_class] = Json::Value(Json::ValueType::objectValue);
   root[_function] = Json::Value(Json::ValueType::objectValue);
+  root[_header] = Out.headerName();
 }
 
 Json::Value JsonConfig::jsonType(const QualType &QT) {
@@ -7,6 +7,7 @@
 #include <clang/Tooling/Tooling.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Error.h>
+#include <llvm/Support/Regex.h>
 #include <llvm/Support/raw_os_ostream.h>
 
 #include <filesystem>
@@ -40,6 +41,13 @@ int main(int argc, const char **argv) {
     return -1;
   }
   tooling::CommonOptionsParser &OptionsParser = *e;
+  for (auto &p : BatchPatterns) {
+    std::string err;
+    if (!Regex(p).isValid(err)) {
+      std::cerr << "Error: invalid --batch pattern '" << p << "': " << err << std::endl;
+      return -1;
+    }
+  }
   std::vector<std::string> sources = OptionsParser.getSourcePathList();
   tooling::ClangTool Tool(OptionsParser.getCompilations(), sources);
   path stem;
@@ -59,7 +67,13 @@ int main(int argc, const char **argv) {
   FC.exclude_decls = ExcludeDecl;
   FC.no_deprecated = NoDeprecated;
   std::cout << "Writing library to: " << stem.string() << ".*" << std::endl;
-  FileOutputs fout(stem, sources);
+  OutputConfig OC;
+  OC.split = SplitHeaders != SplitNone;
+  OC.bench = Bench;
+  FileOutputs fout(stem, sources, OC);
+  if (!ExcludesFile.empty()) fout.addDependency(ExcludesFile.getValue());
+  for (auto &s : CHeadersFiles) fout.addDependency(s);
+  for (auto &s : Imports) fout.addDependency(s);
   UppActionFactory Factory(fout, FC);
   int ret = Tool.run(&Factory);
   return ret;
@@ -30,3 +30,75 @@ cl::opt<bool> NoDeprecated("no-deprecated",
 cl::opt<bool> Verbose(
     "v", cl::desc("Enable verbose output for debugging (multiple lines per declaration)"),
     cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> TranslateExceptions(
+    "translate-exceptions",
+    cl::desc("Catch exceptions in stubs of functions that aren't noexcept, and store them in a "
+             "thread-local error for C to check"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::list<std::string> BatchPatterns(
+    "batch",
+    cl::desc("Emit batched variants of the functions, or methods of the classes, whose fully "
+             "qualified names match the regular expression"),
+    cl::ZeroOrMore, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> InlineAccessors(
+    "inline-accessors",
+    cl::desc("Parse the bodies of methods defined in classes, and emit trivial field accessors as "
+             "static inline C functions over the mirror structs"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> ElideDefaultTemplateArgs(
+    "elide-default-template-args",
+    cl::desc("Leave template arguments that are the same as the default out of C names"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<unsigned> MaxTemplateNameLength(
+    "max-template-name",
+    cl::desc("Replace the template arguments in C names with a hash when they are longer than "
+             "this (0 for no limit)"),
+    cl::init(0), cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> AliasStubs(
+    "alias-stubs",
+    cl::desc("Make stubs of standard container specializations that differ only by the types "
+             "pointers point to aliases of a single implementation, on ELF platforms"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<SplitMode> SplitHeaders(
+    "split-headers",
+    cl::desc("Split the functions and variables of the generated header into smaller headers"),
+    cl::values(clEnumValN(SplitNone, "none", "Generate a single header"),
+               clEnumValN(SplitNamespace, "namespace", "One header per C++ namespace"),
+               clEnumValN(SplitSource, "source", "One header per wrapped C++ header")),
+    cl::init(SplitNone), cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> CompactHeader(
+    "compact-header",
+    cl::desc("Leave out the location and name comments of each declaration in the header"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> Quarantine(
+    "quarantine",
+    cl::desc("Exclude template members that fail to instantiate, and declarations that fail to "
+             "generate, instead of stopping"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<bool> Bench(
+    "bench",
+    cl::desc("Generate a program that times each stub with simple arguments against calling the "
+             "C++ function directly"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::opt<std::string> NamesFile(
+    "names-file",
+    cl::desc("JSON file of the C names given to declarations, which are kept the same when it's "
+             "read by later runs, and new names are added to"),
+    cl::Optional, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
+
+cl::list<std::string> Imports(
+    "import",
+    cl::desc("JSON output of a library generated earlier. Declarations it already wraps are used "
+             "from it instead of being generated again"),
+    cl::ZeroOrMore, cl::cat(UppCategory), cl::sub(*cl::AllSubCommands));
@@ -18,15 +18,34 @@ static void sanitize(std::string &name) {
   }
 }
 
-FileOutputs::FileOutputs(const path &stem, const std::vector<std::string> &sources)
+// Escape a path for a Makefile rule
+static std::string escapeDep(const std::string &path) {
+  std::string escaped;
+  for (char c : path) {
+    if (c == ' ' || c == '#') escaped += '\\';
+    if (c == '$') escaped += '$';
+    escaped += c;
+  }
+  return escaped;
+}
+
+FileOutputs::FileOutputs(const path &stem, const std::vector<std::string> &sources,
+                         const OutputConfig &cfg)
     : _outheader(path(stem).concat(".h")),
       _outsource(path(stem).concat(".cpp")),
       _outjson(path(stem).concat(".json")),
-      _hf(_outheader),
+      _outmap(path(stem).concat(".map")),
+      _outinst(path(stem).concat("_inst.cpp")),
+      _outdep(path(stem).concat(".d")),
+      _outexcludes(path(stem).concat(".excludes.txt")),
+      _outtypes(cfg.split ? path(stem).concat("_types.h") : _outheader),
+      _outbench(path(stem).concat("_bench.cpp")),
+      _hf(_outtypes),
       _sf(_outsource),
-      _json(Json::ValueType::objectValue) {
+      _json(Json::ValueType::objectValue),
+      _cfg(cfg) {
   if (_hf.fail()) {
-    std::cerr << "Error: failed to open " << _outheader << " for writing!" << std::endl;
+    std::cerr << "Error: failed to open the header of " << stem << " for writing!" << std::endl;
     std::exit(1);
   }
   if (_sf.fail()) {
@@ -35,21 +54,68 @@ FileOutputs::FileOutputs(const path &stem, const std::vector<std::string> &sourc
   }
   _macroname = stem.filename().string();
   sanitize(_macroname);
+  _exportmacro = _macroname + "_CIFGEN_API";
   _hf << "/*\n";
   _hf << " * This header file was generated automatically by unplusplus.\n";
   _hf << " */\n";
-  _hf << "#ifndef " << _macroname << "_CIFGEN_H\n";
-  _hf << "#define " << _macroname << "_CIFGEN_H\n";
+  // When split, this is the header with the types that all the parts share
+  std::string guard = _macroname + (_cfg.split ? "_CIFGEN_TYPES_H" : "_CIFGEN_H");
+  _hf << "#ifndef " << guard << "\n";
+  _hf << "#define " << guard << "\n";
   _hf << "#ifdef __cplusplus\n";
   for (const auto &src : sources) {
     _hf << "#include \"" << src << "\"\n";
   }
   _hf << "extern \"C\" {\n";
   _hf << "#endif // __cplusplus\n\n";
+  _hf << "#ifndef UPP_NOEXCEPT\n";
+  _hf << "#ifdef __cplusplus\n";
+  _hf << "#define UPP_NOEXCEPT noexcept\n";
+  _hf << "#else\n";
+  _hf << "#define UPP_NOEXCEPT\n";
+  _hf << "#endif // __cplusplus\n";
+  _hf << "#endif // UPP_NOEXCEPT\n\n";
+  // The mirror structs reproduce explicit alignment and packing
+  _hf << "#ifndef UPP_ALIGNAS\n";
+  _hf << "#ifdef __cplusplus\n";
+  _hf << "#define UPP_ALIGNAS(n) alignas(n)\n";
+  _hf << "#else\n";
+  _hf << "#define UPP_ALIGNAS(n) _Alignas(n)\n";
+  _hf << "#endif // __cplusplus\n";
+  _hf << "#endif // UPP_ALIGNAS\n";
+  _hf << "#ifndef UPP_PACKED\n";
+  _hf << "#if defined(__GNUC__)\n";
+  _hf << "#define UPP_PACKED __attribute__((packed))\n";
+  _hf << "#else\n";
+  _hf << "#define UPP_PACKED\n";
+  _hf << "#endif\n";
+  _hf << "#endif // UPP_PACKED\n\n";
+  // Only the C API is exported, when the library is built with hidden visibility
+  _hf << "#ifndef " << _exportmacro << "\n";
+  _hf << "#if defined(_WIN32)\n";
+  _hf << "#ifdef " << _macroname << "_CIFGEN_BUILD\n";
+  _hf << "#define " << _exportmacro << " __declspec(dllexport)\n";
+  _hf << "#elif defined(" << _macroname << "_CIFGEN_STATIC)\n";
+  _hf << "#define " << _exportmacro << "\n";
+  _hf << "#else\n";
+  // exported variables can only be linked from a DLL when they are imported
+  _hf << "#define " << _exportmacro << " __declspec(dllimport)\n";
+  _hf << "#endif\n";
+  _hf << "#elif defined(__GNUC__)\n";
+  _hf << "#define " << _exportmacro << " __attribute__((visibility(\"default\")))\n";
+  _hf << "#else\n";
+  _hf << "#define " << _exportmacro << "\n";
+  _hf << "#endif\n";
+  _hf << "#endif // " << _exportmacro << "\n\n";
 
   _sf << "/*\n";
   _sf << " * This source file was generated automatically by unplusplus.\n";
   _sf << " */\n";
+  _sf << "#include <algorithm>\n";
+  _sf << "#include <iterator>\n";
+  _sf << "#include <memory>\n";
+  _sf << "#include <new>\n";
+  _sf << "#define " << _macroname << "_CIFGEN_BUILD\n";
   _sf << "#include \"" << _outheader.string() << "\"\n\n";
 
   _exclude_headers.emplace("bits/mathcalls.h");
@@ -59,7 +125,23 @@ FileOutputs::~FileOutputs() {
   _hf << "#ifdef __cplusplus\n";
   _hf << "} // extern \"C\"\n";
   _hf << "#endif // __cplusplus\n";
-  _hf << "#endif // " << _macroname << "_CIFGEN_H\n";
+  // The stubs use the members instantiated in the instantiation source, instead of their own copies
+  if (!_instantiations.empty()) {
+    _hf << "\n#if defined(__cplusplus) && defined(" << _macroname << "_CIFGEN_BUILD)\n";
+    for (const auto &decl : _instantiations) _hf << "extern template " << decl << ";\n";
+    _hf << "#endif // " << _macroname << "_CIFGEN_BUILD\n";
+  }
+  _hf << "#endif // " << _macroname << (_cfg.split ? "_CIFGEN_TYPES_H" : "_CIFGEN_H") << "\n";
+
+  // Discarded output may have been longer than what replaced it
+  std::streampos hend = _hf.tellp();
+  _hf.close();
+  std::filesystem::resize_file(_outtypes, hend);
+  std::streampos send = _sf.tellp();
+  _sf.close();
+  std::filesystem::resize_file(_outsource, send);
+
+  if (_cfg.split) writeParts();
 
   Json::StreamWriterBuilder wbuilder;
   wbuilder["indentation"] = " ";
@@ -67,6 +149,198 @@ FileOutputs::~FileOutputs() {
   std::ofstream ofjson(_outjson);
   writer->write(_json, &ofjson);
   ofjson << std::endl;
+
+  // A version script for the linker, that hides everything but the C API
+  std::ofstream ofmap(_outmap);
+  ofmap << "{\n";
+  ofmap << "  global:\n";
+  for (const auto &e : _exports) ofmap << "    " << e << ";\n";
+  ofmap << "  local:\n";
+  ofmap << "    *;\n";
+  ofmap << "};\n";
+
+  std::ofstream ofinst(_outinst);
+  ofinst << "/*\n";
+  ofinst << " * This source file was generated automatically by unplusplus.\n";
+  ofinst << " */\n";
+  ofinst << "#define " << _macroname << "_CIFGEN_BUILD\n";
+  ofinst << "#include \"" << _outheader.string() << "\"\n\n";
+  for (const auto &decl : _instantiations) ofinst << "template " << decl << ";\n";
+
+  if (_cfg.bench) writeBench();
+
+  if (!_exclusions.empty()) {
+    std::ofstream ofexcludes(_outexcludes);
+    ofexcludes << "# Declarations that failed, to be passed back with --excludes-file\n";
+    for (const auto &e : _exclusions) ofexcludes << e << "\n";
+  }
+
+  // A Makefile rule with every file that was read, so the build knows when to run again
+  std::ofstream ofdep(_outdep);
+  ofdep << escapeDep(_outheader.string()) << ":";
+  for (const auto &dep : _dependencies) ofdep << " \\\n  " << escapeDep(dep);
+  ofdep << "\n";
+}
+
+void FileOutputs::setPartition(const std::string &name) {
+  if (!_cfg.split || name.empty()) {
+    _part = nullptr;
+  } else {
+    _part = &_parts[name];
+    _mark.parts.emplace(_part, _part->tellp());
+  }
+}
+
+void FileOutputs::mark() {
+  _mark.parts.clear();
+  if (_part) _mark.parts.emplace(_part, _part->tellp());
+  _mark.hf = _hf.tellp();
+  _mark.sf = _sf.tellp();
+  _mark.exports = _exports.size();
+  _mark.instantiations = _instantiations.size();
+  _mark.cheaders = _cheaderOrder.size();
+  _mark.imports = _importOrder.size();
+  _mark.benchmarks = _benchmarks.size();
+  _mark.json.clear();
+}
+
+void FileOutputs::rollback() {
+  _hf.seekp(_mark.hf);
+  _sf.seekp(_mark.sf);
+  for (auto &p : _mark.parts) {
+    p.first->str(p.first->str().substr(0, p.second));
+    p.first->seekp(0, std::ios::end);
+  }
+  _mark.parts.clear();
+  _exports.resize(_mark.exports);
+  _instantiations.resize(_mark.instantiations);
+  for (size_t i = _mark.cheaders; i < _cheaderOrder.size(); ++i) _cheaders.erase(_cheaderOrder[i]);
+  _cheaderOrder.resize(_mark.cheaders);
+  for (size_t i = _mark.imports; i < _importOrder.size(); ++i) _imports.erase(_importOrder[i]);
+  _importOrder.resize(_mark.imports);
+  _benchmarks.resize(_mark.benchmarks);
+  // Restore the entries in reverse, so an entry changed twice gets its value from before the mark
+  for (auto it = _mark.json.rbegin(); it != _mark.json.rend(); ++it) {
+    Json::Value &section = _json[std::get<0>(*it)];
+    if (std::get<2>(*it).isNull())
+      section.removeMember(std::get<1>(*it));
+    else
+      section[std::get<1>(*it)] = std::get<2>(*it);
+  }
+  _mark.json.clear();
+}
+
+Json::Value &FileOutputs::jsonEntry(const std::string &section, const std::string &name) {
+  Json::Value &s = _json[section];
+  _mark.json.emplace_back(section, name, s.get(name, Json::Value()));
+  return s[name];
+}
+
+void FileOutputs::writeParts() {
+  std::string types = _outheader.stem().string() + "_types.h";
+  std::ofstream umbrella(_outheader);
+  umbrella << "/*\n";
+  umbrella << " * This header file was generated automatically by unplusplus.\n";
+  umbrella << " */\n";
+  umbrella << "#ifndef " << _macroname << "_CIFGEN_H\n";
+  umbrella << "#define " << _macroname << "_CIFGEN_H\n";
+  umbrella << "#include \"" << types << "\"\n";
+
+  for (const auto &part : _parts) {
+    std::string name = part.first;
+    sanitize(name);
+    path file = path(_outheader).replace_extension(name + ".h");
+    std::string guard = _macroname + "_CIFGEN_" + name + "_H";
+    umbrella << "#include \"" << file.filename().string() << "\"\n";
+
+    std::ofstream hf(file);
+    hf << "/*\n";
+    hf << " * This header file was generated automatically by unplusplus.\n";
+    hf << " */\n";
+    hf << "#ifndef " << guard << "\n";
+    hf << "#define " << guard << "\n";
+    hf << "#include \"" << types << "\"\n";
+    hf << "#ifdef __cplusplus\n";
+    hf << "extern \"C\" {\n";
+    hf << "#endif // __cplusplus\n\n";
+    hf << part.second.str();
+    hf << "#ifdef __cplusplus\n";
+    hf << "} // extern \"C\"\n";
+    hf << "#endif // __cplusplus\n";
+    hf << "#endif // " << guard << "\n";
+  }
+  umbrella << "#endif // " << _macroname << "_CIFGEN_H\n";
+}
+
+void FileOutputs::writeBench() {
+  std::ofstream bf(_outbench);
+  bf << "/*\n";
+  bf << " * This source file was generated automatically by unplusplus.\n";
+  bf << " * It times each stub against calling the C++ function directly, and writes the\n";
+  bf << " * times in nanoseconds to a CSV file, given as the first argument.\n";
+  bf << " */\n";
+  bf << "#include <algorithm>\n";
+  bf << "#include <chrono>\n";
+  bf << "#include <fstream>\n";
+  bf << "#include <iostream>\n";
+  bf << "#include <string>\n";
+  bf << "#include <type_traits>\n";
+  bf << "#include <vector>\n";
+  bf << "#include \"" << _outheader.filename().string() << "\"\n\n";
+  bf << "namespace {\n";
+  bf << "// Arguments are read from and results written to volatiles, so calls aren't elided\n";
+  bf << "volatile int upp_zero = 0;\n";
+  bf << "volatile double upp_sink;\n\n";
+  bf << "struct upp_result {\n";
+  bf << "  std::string name;\n";
+  bf << "  double cpp;\n";
+  bf << "  double c;\n";
+  bf << "};\n\n";
+  bf << "// Get the best time of a call in nanoseconds\n";
+  bf << "template <class F>\n";
+  bf << "double upp_time(F f) {\n";
+  bf << "  const long iterations = 100000;\n";
+  bf << "  double best = 0;\n";
+  bf << "  for (int run = 0; run < 5; ++run) {\n";
+  bf << "    auto start = std::chrono::steady_clock::now();\n";
+  bf << "    for (long n = 0; n < iterations; ++n) {\n";
+  bf << "      if constexpr (std::is_void<decltype(f())>::value) {\n";
+  bf << "        f();\n";
+  bf << "      } else {\n";
+  bf << "        upp_sink = static_cast<double>(f());\n";
+  bf << "      }\n";
+  bf << "    }\n";
+  bf << "    std::chrono::duration<double, std::nano> time =\n";
+  bf << "        std::chrono::steady_clock::now() - start;\n";
+  bf << "    if (run == 0 || time.count() < best) best = time.count();\n";
+  bf << "  }\n";
+  bf << "  return best / iterations;\n";
+  bf << "}\n";
+  bf << "}  // namespace\n\n";
+  bf << "int main(int argc, char **argv) {\n";
+  bf << "  std::vector<upp_result> results;\n";
+  for (const auto &b : _benchmarks) {
+    bf << "  {\n";
+    if (!b.setup.empty()) bf << "    " << b.setup << "\n";
+    bf << "    results.push_back({\"" << b.name << "\",\n";
+    bf << "                       upp_time([&] { return " << b.cpp << "; }),\n";
+    bf << "                       upp_time([&] { return " << b.c << "; })});\n";
+    bf << "  }\n";
+  }
+  bf << "  // The functions with the most overhead first\n";
+  bf << "  std::sort(results.begin(), results.end(),\n";
+  bf << "            [](const upp_result &a, const upp_result &b) {\n";
+  bf << "              return a.c - a.cpp > b.c - b.cpp;\n";
+  bf << "            });\n\n";
+  bf << "  std::ofstream csv(argc > 1 ? argv[1] : \"" << _outheader.stem().string()
+     << "_bench.csv\");\n";
+  bf << "  csv << \"function,cpp_ns,c_ns,overhead_ns\\n\";\n";
+  bf << "  for (const auto &r : results) {\n";
+  bf << "    csv << r.name << \",\" << r.cpp << \",\" << r.c << \",\" << r.c - r.cpp << \"\\n\";\n";
+  bf << "  }\n";
+  bf << "  std::cout << results.size() << \" functions timed\" << std::endl;\n";
+  bf << "  return 0;\n";
+  bf << "}\n";
 }
 
 void FileOutputs::addCHeader(const std::string &path) {
@@ -78,9 +352,23 @@ void FileOutputs::addCHeader(const std::string &path) {
   if (use) {
     _hf << "#include \"" << path << "\"\n\n";
     _cheaders.emplace(path);
+    _cheaderOrder.push_back(path);
   }
 }
 
+void FileOutputs::addImport(const std::string &path) {
+  if (!_imports.emplace(path).second) return;
+  _importOrder.push_back(path);
+  // The imported header includes its C++ headers, which can't have C linkage
+  _hf << "#ifdef __cplusplus\n";
+  _hf << "} // extern \"C\"\n";
+  _hf << "#endif // __cplusplus\n";
+  _hf << "#include \"" << path << "\"\n";
+  _hf << "#ifdef __cplusplus\n";
+  _hf << "extern \"C\" {\n";
+  _hf << "#endif // __cplusplus\n\n";
+}
+
 SubOutputs::~SubOutputs() {
   _parent.hf() << _hf.str();
   _parent.sf() << _sf.str();
@@ -0,0 +1,14 @@
+#include <stdexcept>
+
+namespace A {
+int safe(int a) noexcept;
+int risky(int a);
+struct Foo {
+  Foo() = default;
+  ~Foo() = default;
+  int get() const noexcept { return 1; }
+  void check(int a) {
+    if (a < 0) throw std::invalid_argument("negative");
+  }
+};
+}  // namespace A
@@ -0,0 +1,19 @@
+namespace virt {
+struct Shape {
+  virtual ~Shape();
+  virtual double area() const = 0;
+  virtual void scale(double factor);
+  int id() const;
+};
+
+struct Square : Shape {
+  double side;
+  double area() const override;
+  void scale(double factor) final;
+};
+
+struct Circle final : Shape {
+  double radius;
+  double area() const override;
+};
+}  // namespace virt
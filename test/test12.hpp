@@ -0,0 +1,20 @@
+namespace layout {
+class Opaque {
+  struct Hidden {
+    double d;
+    int i;
+  };
+  char tag;
+  Hidden hidden;
+
+ public:
+  int after;
+  Opaque();
+};
+
+struct Holder {
+  char c;
+  Opaque o;
+  short s;
+};
+}  // namespace layout
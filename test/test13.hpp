@@ -0,0 +1,38 @@
+namespace byval {
+struct Vec2 {
+  float x;
+  float y;
+};
+
+struct Small {
+  int id;
+  double weight;
+};
+
+struct Big {
+  double values[8];
+};
+
+struct Owner {
+  Owner();
+  Owner(const Owner &other);
+  ~Owner();
+  int *data;
+};
+
+struct Empty {};
+
+Vec2 add(Vec2 a, Vec2 b);
+Small make_small(int id);
+double total(Big big);
+Big make_big();
+Owner make_owner(int size);
+int count(Owner owner);
+Empty nothing(Empty e);
+
+struct Shape {
+  Vec2 center() const;
+  void move(Vec2 by);
+  Vec2 origin;
+};
+}  // namespace byval
@@ -0,0 +1,21 @@
+#include <array>
+#include <string>
+#include <vector>
+
+namespace contiguous {
+struct Point {
+  int x;
+  int y;
+};
+
+struct Named {
+  std::string name;
+};
+
+std::vector<int> &ints();
+std::vector<Point> &points();
+std::array<double, 4> &quad();
+std::string &text();
+std::vector<bool> &flags();
+std::vector<Named> &names();
+}  // namespace contiguous
@@ -0,0 +1,22 @@
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace text {
+std::size_t length(std::string s);
+std::size_t length_ref(const std::string &s);
+std::size_t length_view(std::string_view s);
+std::size_t length_wide(const std::wstring &s);
+int sum(std::span<const int> values);
+void fill(std::span<int> values, int value);
+int first(std::span<const int, 4> values);
+std::string upper(const std::string &s);
+std::string_view trim(std::string_view s);
+const std::string &name();
+
+struct Document {
+  const std::string &title() const;
+  void set_title(std::string_view title);
+  std::string body() const;
+};
+}  // namespace text
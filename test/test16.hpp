@@ -0,0 +1,19 @@
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace iterable {
+struct Item {
+  int id;
+  double price;
+};
+
+std::list<Item> &items();
+std::set<int> &ids();
+std::map<int, double> &prices();
+std::unordered_map<std::string, int> &counts();
+std::vector<bool> &flags();
+}  // namespace iterable
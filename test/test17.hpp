@@ -0,0 +1,34 @@
+namespace accessors {
+struct Base {
+  int base_id;
+};
+
+class Particle : public Base {
+  float mass;
+  double pos[3];
+  union {
+    int flags;
+    unsigned bits;
+  };
+
+ public:
+  float get_mass() const { return mass; }
+  void set_mass(float m) { mass = m; }
+  float half_mass() const { return mass * 0.5f; }
+  double scaled(double s) const { return pos[0] * s + 1e-3; }
+  long double precise() const { return pos[1] * 0.1L; }
+  double x() const { return pos[0]; }
+  void set_x(double v) { pos[0] = v; }
+  int id() const { return base_id; }
+  bool heavy() const { return mass > 10.0f; }
+  unsigned long big() const { return 4000000000UL; }
+  int get_flags() const { return flags; }
+  void clear() {
+    mass = 0;
+    flags = 0;
+  }
+  int clamp(int v) const { return v < 0 ? -v : v; }
+  int not_inlined() const;
+  int calls() const { return not_inlined(); }
+};
+}  // namespace accessors
@@ -0,0 +1,25 @@
+#include <climits>
+
+namespace constants {
+constexpr int answer = 42;
+constexpr int lowest = INT_MIN;
+constexpr long long big = LLONG_MAX;
+constexpr unsigned long long ubig = ULLONG_MAX;
+constexpr float ratio = 0.5f;
+constexpr double pi = 3.14159265358979323846;
+const int counted = 7;
+const double runtime_rate = 1.5;
+extern const int external;
+volatile const int hardware = 3;
+constexpr bool enabled = true;
+constexpr char letter = 'a';
+
+enum class Mode { Off, On };
+constexpr Mode mode = Mode::On;
+
+struct Limits {
+  static constexpr int max = 100;
+  static const int min = -100;
+  static const double scale;
+};
+}  // namespace constants
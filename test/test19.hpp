@@ -0,0 +1,20 @@
+#include <climits>
+
+#define MACRO_INT 42
+#define MACRO_NEGATIVE -7
+#define MACRO_HEX 0xFFu
+#define MACRO_LONG 123456789012LL
+#define MACRO_FLOAT 2.5f
+#define MACRO_DOUBLE 1e-9
+#define MACRO_STRING "version 1.0"
+#define MACRO_CHAR 'x'
+#define MACRO_PAREN (16)
+#define MACRO_EXPR (MACRO_INT + 1)
+#define MACRO_LIMIT INT_MAX
+#define MACRO_FUNCTION(x) ((x) * 2)
+#define MACRO_EMPTY
+#define _MACRO_RESERVED 1
+
+namespace macros {
+int use(int a = MACRO_INT);
+}  // namespace macros
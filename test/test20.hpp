@@ -0,0 +1,21 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace names {
+template <typename T, typename Tag = void, int N = 4>
+struct Box {
+  T values[N];
+  T first() const;
+};
+
+struct Tag {};
+
+Box<int> &defaults();
+Box<int, Tag> &tagged();
+Box<int, void, 8> &wide();
+std::vector<std::string> &strings();
+std::map<std::string, std::vector<std::pair<int, double>>> &nested();
+std::unique_ptr<Box<std::map<std::string, std::vector<std::string>>, Tag, 2>> &deep();
+}  // namespace names
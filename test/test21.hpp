@@ -0,0 +1,49 @@
+#include <cstdint>
+
+namespace packing {
+struct __attribute__((packed)) Packed {
+  char tag;
+  int value;
+  double weight;
+};
+
+struct PackedField {
+  char tag;
+  int value __attribute__((packed));
+  short count;
+};
+
+#pragma pack(push, 2)
+struct Pragma {
+  char tag;
+  int value;
+  double weight;
+};
+#pragma pack(pop)
+
+struct alignas(32) Aligned {
+  float lanes[4];
+};
+
+struct AlignedField {
+  char tag;
+  alignas(16) int value;
+  std::uint8_t end;
+};
+
+typedef double aligned_double __attribute__((aligned(16)));
+
+struct AlignedTypedef {
+  char tag;
+  aligned_double value;
+};
+
+struct Holder {
+  char tag;
+  Aligned aligned;
+  Packed packed;
+};
+
+Aligned make_aligned();
+double sum(const Packed &p);
+}  // namespace packing
@@ -0,0 +1,22 @@
+// Generate with --names-file, then again with -DUPP_TEST_SECOND_RUN and the same names file.
+// The names of the overloads from the first run must not change.
+namespace stable {
+#ifdef UPP_TEST_SECOND_RUN
+int scale(char c);
+#endif
+int scale(int i);
+int scale(double d);
+#ifdef UPP_TEST_SECOND_RUN
+int scale(float f);
+#endif
+
+struct Widget {
+#ifdef UPP_TEST_SECOND_RUN
+  Widget(const char *name);
+#endif
+  Widget(int size);
+  Widget(int width, int height);
+  void resize(int size);
+  void resize(int width, int height);
+};
+}  // namespace stable
@@ -0,0 +1,12 @@
+#include <string>
+#include <vector>
+
+namespace base {
+struct Point {
+  int x;
+  int y;
+};
+
+std::vector<Point> &points();
+std::string describe(const Point &p);
+}  // namespace base
@@ -0,0 +1,18 @@
+// Generate test23-base.hpp first, then this header with --import of its JSON output.
+// The declarations of base, and the std types it wrapped, must come from its header.
+#include <string>
+#include <vector>
+
+#include "test23-base.hpp"
+
+namespace derived {
+struct Segment {
+  base::Point from;
+  base::Point to;
+};
+
+base::Point midpoint(const Segment &s);
+std::vector<base::Point> &path();
+std::vector<Segment> &segments();
+std::string label(const base::Point &p);
+}  // namespace derived